@@ -0,0 +1,381 @@
+#include "ansi.h"
+
+#define MAX_COLOR_PAIRS   COLORS_PAIR_COUNT
+#define SGR_BUF_SIZE      48
+#define ESC               "\033"
+#define SAVE_CURSOR       ESC "7"
+#define RESTORE_CURSOR    ESC "8"
+#define ERASE_LINE        ESC "[K"
+
+// The shortest runs that are cheaper to skip or erase than to write out,
+// erasing in the middle of a line also requires the cursor to be moved past the run
+#define MIN_SKIP_LENGTH   5
+#define MIN_ERASE_LENGTH  5
+#define MIN_ERASE_LENGTH_MOVE 10
+
+// Every cell could in theory need its own SGR sequence
+#define OUTPUT_BUF_SIZE   (PAGE_LINES * (PAGE_COLS * (SGR_BUF_SIZE + 1) + 16) + 16)
+
+typedef struct output_buffer {
+    char data[OUTPUT_BUF_SIZE];
+    size_t size;
+} output_buffer_t;
+
+// The state of the terminal while a frame is being written
+typedef struct terminal_state {
+    int line, col;          // -1 if unknown
+    attr_t attr;
+    bool has_attr;
+} terminal_state_t;
+
+static output_buffer_t output;
+static bool use_truecolor = false;
+static bool low_bandwidth = false;
+// Whether erasing fills the cells with the current background color, otherwise they
+// get the default background, e.g. in GNU screen
+static bool back_color_erase = false;
+static char pair_sgr[MAX_COLOR_PAIRS][SGR_BUF_SIZE];
+static char pair_fg_sgr[MAX_COLOR_PAIRS][SGR_BUF_SIZE / 2];
+static char pair_bg_sgr[MAX_COLOR_PAIRS][SGR_BUF_SIZE / 2];
+static bool pair_has_default_bg[MAX_COLOR_PAIRS];
+
+static void append(const char *str, size_t length) {
+    if (output.size + length > OUTPUT_BUF_SIZE) {
+        return;
+    }
+
+    memcpy(output.data + output.size, str, length);
+    output.size += length;
+}
+
+static void append_string(const char *str) {
+    append(str, strlen(str));
+}
+
+static void create_color_sgr(char *buf, size_t buf_size, short color, bool background) {
+    short r, g, b;
+
+    if (color < 0) {
+        // Use the default color of the terminal
+        snprintf(buf, buf_size, ";%d", background ? 49 : 39);
+    } else if (use_truecolor && color_content(color, &r, &g, &b) == OK) {
+        // Curses uses the range 0-1000 for the color components
+        snprintf(
+            buf,
+            buf_size,
+            ";%d;2;%d;%d;%d",
+            background ? 48 : 38,
+            r * 255 / 1000,
+            g * 255 / 1000,
+            b * 255 / 1000
+        );
+    } else {
+        snprintf(buf, buf_size, ";%d", (background ? 40 : 30) + color);
+    }
+}
+
+/// @brief Creates the color part of the SGR sequence for each color pair
+static void create_pair_sgr_table() {
+    for (short pair = 0; pair < MAX_COLOR_PAIRS; pair++) {
+        short fg = -1;
+        short bg = -1;
+
+        if (pair == 0 || pair_content(pair, &fg, &bg) != OK) {
+            fg = -1;
+            bg = -1;
+        }
+
+        create_color_sgr(pair_fg_sgr[pair], sizeof(pair_fg_sgr[pair]), fg, false);
+        create_color_sgr(pair_bg_sgr[pair], sizeof(pair_bg_sgr[pair]), bg, true);
+        snprintf(pair_sgr[pair], SGR_BUF_SIZE, "%s%s", pair_fg_sgr[pair], pair_bg_sgr[pair]);
+        pair_has_default_bg[pair] = bg < 0;
+    }
+}
+
+static void append_sgr(attr_t attr) {
+    short pair = PAIR_NUMBER(attr);
+    char buf[SGR_BUF_SIZE + 8];
+    snprintf(
+        buf,
+        sizeof(buf),
+        ESC "[0%s%s%sm",
+        attr & A_BOLD ? ";1" : "",
+        attr & A_UNDERLINE ? ";4" : "",
+        pair < MAX_COLOR_PAIRS ? pair_sgr[pair] : ""
+    );
+    append_string(buf);
+}
+
+/// @brief Only changes the parts of the attributes that differ from the current ones
+static void append_sgr_change(terminal_state_t *state, attr_t attr) {
+    if (!state->has_attr) {
+        append_sgr(attr);
+        state->attr = attr;
+        state->has_attr = true;
+        return;
+    }
+
+    if (state->attr == attr) {
+        return;
+    }
+
+    short from_pair = PAIR_NUMBER(state->attr);
+    short to_pair = PAIR_NUMBER(attr);
+    char buf[SGR_BUF_SIZE + 16];
+    // Skip the ';' of the first parameter
+    size_t length = 1;
+
+    if ((state->attr & A_BOLD) != (attr & A_BOLD)) {
+        length += snprintf(buf + length, sizeof(buf) - length, ";%s", attr & A_BOLD ? "1" : "22");
+    }
+
+    if ((state->attr & A_UNDERLINE) != (attr & A_UNDERLINE)) {
+        length += snprintf(buf + length, sizeof(buf) - length, ";%s", attr & A_UNDERLINE ? "4" : "24");
+    }
+
+    if (from_pair >= MAX_COLOR_PAIRS || to_pair >= MAX_COLOR_PAIRS) {
+        append_sgr(attr);
+        state->attr = attr;
+        return;
+    }
+
+    if (strcmp(pair_fg_sgr[from_pair], pair_fg_sgr[to_pair]) != 0) {
+        length += snprintf(buf + length, sizeof(buf) - length, "%s", pair_fg_sgr[to_pair]);
+    }
+
+    if (strcmp(pair_bg_sgr[from_pair], pair_bg_sgr[to_pair]) != 0) {
+        length += snprintf(buf + length, sizeof(buf) - length, "%s", pair_bg_sgr[to_pair]);
+    }
+
+    state->attr = attr;
+
+    if (length == 1) {
+        // Different pairs with the same colors
+        return;
+    }
+
+    append_string(ESC "[");
+    append(buf + 2, length - 2);
+    append_string("m");
+}
+
+static void append_move(int line, int col) {
+    char buf[32];
+    // Cursor positions are 1-based
+    snprintf(buf, sizeof(buf), ESC "[%d;%dH", line + 1, col + 1);
+    append_string(buf);
+}
+
+/// @brief Moves the cursor using the shortest sequence available
+static void append_move_from(terminal_state_t *state, int line, int col) {
+    char buf[32];
+
+    if (state->line == line && state->col == col) {
+        return;
+    } else if (state->line == line && state->col != -1 && state->col < col) {
+        if (col - state->col == 1) {
+            snprintf(buf, sizeof(buf), ESC "[C");
+        } else {
+            snprintf(buf, sizeof(buf), ESC "[%dC", col - state->col);
+        }
+
+        append_string(buf);
+    } else {
+        append_move(line, col);
+    }
+
+    state->line = line;
+    state->col = col;
+}
+
+/// @brief Checks if a cell can be cleared using an erase sequence,
+///        which fills the cells with the current background color.
+static bool is_erasable(chtype cell) {
+    return (cell & A_CHARTEXT) == ' ' && !(cell & A_UNDERLINE);
+}
+
+/// @brief Counts the number of cells that are equal to the one at col
+static int count_equal(chtype *row, int col) {
+    int length = 1;
+
+    while (col + length < PAGE_COLS && row[col + length] == row[col]) {
+        length++;
+    }
+
+    return length;
+}
+
+static void present_line_low_bandwidth(
+    terminal_state_t *state,
+    chtype *shown,
+    chtype *next,
+    int line,
+    int col,
+    int last,
+    int origin_col,
+    bool force
+) {
+    // Erasing to the end of the line also clears everything to the right of the page
+    bool page_at_right_edge = origin_col + PAGE_COLS >= COLS;
+
+    while (col <= last) {
+        if (!force && shown[col] == next[col]) {
+            int unchanged = 1;
+
+            while (col + unchanged <= last && shown[col + unchanged] == next[col + unchanged]) {
+                unchanged++;
+            }
+
+            // Skip unchanged cells if it is cheaper than writing them
+            if (unchanged >= MIN_SKIP_LENGTH) {
+                col += unchanged;
+                continue;
+            }
+        }
+
+        short pair = PAIR_NUMBER(next[col]);
+        bool default_bg = pair < MAX_COLOR_PAIRS && pair_has_default_bg[pair];
+
+        if (is_erasable(next[col]) && (default_bg || back_color_erase)) {
+            int run = count_equal(next, col);
+            bool to_end = col + run == PAGE_COLS;
+            int min_length = col + run > last ? MIN_ERASE_LENGTH : MIN_ERASE_LENGTH_MOVE;
+
+            if (run >= min_length) {
+                char buf[16];
+                append_move_from(state, line, origin_col + col);
+                append_sgr_change(state, next[col] & (A_ATTRIBUTES & ~A_CHARTEXT));
+
+                if (to_end && (page_at_right_edge || default_bg)) {
+                    append_string(ERASE_LINE);
+                } else {
+                    snprintf(buf, sizeof(buf), ESC "[%dX", run);
+                    append_string(buf);
+                }
+
+                // Erasing does not move the cursor
+                col += run;
+                continue;
+            }
+        }
+
+        append_move_from(state, line, origin_col + col);
+        append_sgr_change(state, next[col] & (A_ATTRIBUTES & ~A_CHARTEXT));
+        char glyph = next[col] & A_CHARTEXT;
+        append(&glyph, 1);
+        state->col++;
+        col++;
+
+        // The cursor might wrap at the right edge of the terminal
+        if (state->col >= COLS) {
+            state->line = -1;
+            state->col = -1;
+        }
+    }
+}
+
+/// @brief Must be called after the colors have been initialized
+/// @param truecolor use 24-bit colors
+/// @param minimal_output write as few bytes as possible for every frame, see 'ansi_present()'
+void ansi_initialize(bool truecolor, bool minimal_output) {
+    use_truecolor = truecolor;
+    low_bandwidth = minimal_output;
+    back_color_erase = tigetflag("bce") > 0;
+    create_pair_sgr_table();
+}
+
+/// @brief Checks if the terminal claims to support 24-bit colors
+bool ansi_supports_truecolor() {
+    const char *colorterm = getenv("COLORTERM");
+
+    if (!colorterm) {
+        return false;
+    }
+
+    return strcmp(colorterm, "truecolor") == 0 || strcmp(colorterm, "24bit") == 0;
+}
+
+/// @brief Writes the cells that differ between the shown and the next frame
+///        directly to the terminal, using a single write. With minimal output,
+///        unchanged cells are skipped, runs of blank cells are erased and only
+///        the attributes that change are written.
+/// @param shown the frame that is currently visible, updated to match next
+/// @param origin_line the line of the top left corner of the page on the screen
+/// @param origin_col the column of the top left corner of the page on the screen
+/// @param force write every cell, e.g. if the screen has been cleared
+/// @return the number of bytes that were written
+size_t ansi_present(frame_t *shown, frame_t *next, int origin_line, int origin_col, bool force) {
+    output.size = 0;
+    // Curses keeps track of the cursor and attributes, so they must be restored afterwards
+    append_string(SAVE_CURSOR);
+    attr_t current_attr = 0;
+    bool has_attr = false;
+    terminal_state_t state = {
+        .line = -1,
+        .col = -1,
+        .attr = 0,
+        .has_attr = false
+    };
+
+    for (int line = 0; line < PAGE_LINES; line++) {
+        int first = 0;
+        int last = PAGE_COLS - 1;
+
+        if (!force) {
+            while (first < PAGE_COLS && shown->cells[line][first] == next->cells[line][first]) {
+                first++;
+            }
+
+            if (first == PAGE_COLS) {
+                continue;
+            }
+
+            while (shown->cells[line][last] == next->cells[line][last]) {
+                last--;
+            }
+        }
+
+        if (low_bandwidth) {
+            present_line_low_bandwidth(
+                &state,
+                shown->cells[line],
+                next->cells[line],
+                origin_line + line,
+                first,
+                last,
+                origin_col,
+                force
+            );
+            memcpy(&shown->cells[line][first], &next->cells[line][first], (last - first + 1) * sizeof(chtype));
+            continue;
+        }
+
+        append_move(origin_line + line, origin_col + first);
+
+        for (int col = first; col <= last; col++) {
+            chtype cell = next->cells[line][col];
+            attr_t attr = cell & (A_ATTRIBUTES & ~A_CHARTEXT);
+
+            if (!has_attr || attr != current_attr) {
+                append_sgr(attr);
+                current_attr = attr;
+                has_attr = true;
+            }
+
+            char glyph = cell & A_CHARTEXT;
+            append(&glyph, 1);
+        }
+
+        memcpy(&shown->cells[line][first], &next->cells[line][first], (last - first + 1) * sizeof(chtype));
+    }
+
+    append_string(RESTORE_CURSOR);
+
+    if (output.size == strlen(SAVE_CURSOR) + strlen(RESTORE_CURSOR)) {
+        // Nothing has changed
+        return 0;
+    }
+
+    output_write(output.data, output.size);
+    return output.size;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <curses.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "frame.h"
+#include "output.h"
+#include "colors.h"
+#include "shared.h"
+
+void ansi_initialize(bool truecolor, bool minimal_output);
+size_t ansi_present(frame_t *shown, frame_t *next, int origin_line, int origin_col, bool force);
+bool ansi_supports_truecolor();
@@ -9,9 +9,12 @@ typedef struct response_chunk {
     size_t size;
 } response_chunk_t;
 
-static CURL *curl = NULL;
-static CURLcode res_code = -1;
-static char url_buf[URL_BUF_SIZE];
+// Every thread that makes requests has its own handle, since a handle can
+// only be used by one thread at a time
+static _Thread_local CURL *curl = NULL;
+static _Thread_local CURLcode res_code = -1;
+static _Thread_local char url_buf[URL_BUF_SIZE];
+static _Thread_local api_cancel_check_t cancel_check = NULL;
 
 static size_t write_callback(void *data, size_t size, size_t nmemb, void *extra) {
     size_t realsize = size * nmemb;
@@ -33,6 +36,41 @@ static size_t write_callback(void *data, size_t size, size_t nmemb, void *extra)
     return realsize;
 }
 
+static int progress_callback(void *data, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow) {
+    // Returning non-zero aborts the transfer
+    return cancel_check && cancel_check();
+}
+
+/// @brief Adds the phases of a request that has completed to the trace, from the times that
+///        curl measured since the request started
+static void trace_request(CURL *handle, uint16_t page_id, size_t size) {
+    if (!trace_is_enabled()) {
+        return;
+    }
+
+    curl_off_t dns_us = 0, connect_us = 0, tls_us = 0, first_byte_us = 0, total_us = 0;
+    curl_easy_getinfo(handle, CURLINFO_NAMELOOKUP_TIME_T, &dns_us);
+    curl_easy_getinfo(handle, CURLINFO_CONNECT_TIME_T, &connect_us);
+    curl_easy_getinfo(handle, CURLINFO_APPCONNECT_TIME_T, &tls_us);
+    curl_easy_getinfo(handle, CURLINFO_STARTTRANSFER_TIME_T, &first_byte_us);
+    curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME_T, &total_us);
+
+    // The connection is only set up by the first request of a handle, the rest reuse it
+    uint64_t start_us = trace_get_time_us() - total_us;
+    uint64_t setup_us = tls_us > connect_us ? tls_us : connect_us;
+    trace_complete("request", page_id, start_us, total_us);
+    trace_complete("dns", page_id, start_us, dns_us);
+    trace_complete("connect", page_id, start_us + dns_us, connect_us - dns_us);
+
+    if (tls_us > 0) {
+        trace_complete("tls", page_id, start_us + connect_us, tls_us - connect_us);
+    }
+
+    trace_complete("wait", page_id, start_us + setup_us, first_byte_us - setup_us);
+    trace_complete("transfer", page_id, start_us + first_byte_us, total_us - first_byte_us);
+    trace_counter("response_bytes", size);
+}
+
 static void create_page_range(char *buf, size_t buf_size, uint16_t start, uint16_t end) {
     assert(buf != NULL);
     assert(buf_size != 0);
@@ -63,52 +101,141 @@ static void create_endpoint_url(char *buf, size_t buf_size, uint16_t start, uint
 
 
 // TODO: Return error(s) and display in UI
-static page_t *make_request(uint16_t start, uint16_t end) {
+/// @param modified_since only respond if the page has been modified after this unix time, 0 to always respond
+/// @return true if the response was received, the response data must be free'd by the caller
+static bool make_request(uint16_t start, uint16_t end, uint64_t modified_since, response_chunk_t *chunk) {
     assert(start != 0);
 
-    if (!curl) {
-        api_initialize();
+    if (!curl && !(curl = curl_easy_init())) {
+        error_set_with_string(TTT_ERROR_REQUEST_FAILED, "ERROR: Failed to initialize curl");
+        return false;
     }
 
     create_endpoint_url(url_buf, URL_BUF_SIZE, start, end);
-    response_chunk_t chunk = {
-        // TODO: Allocate more memory at once to prevent unnecessary realloc's?
-        .data = malloc(1),
-        .size = 0
-    };
+    // TODO: Allocate more memory at once to prevent unnecessary realloc's?
+    chunk->data = malloc(1);
+    chunk->size = 0;
     curl_easy_setopt(curl, CURLOPT_URL,           url_buf);
-    curl_easy_setopt(curl, CURLOPT_NOPROGRESS,    1L);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS,    cancel_check ? 0L : 1L);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, progress_callback);
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA,     &chunk);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA,     chunk);
     curl_easy_setopt(curl, CURLOPT_USERAGENT,     "libcurl-agent/1.0");
+    // Timeouts must not use signals when there are several threads
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL,      1L);
+    curl_easy_setopt(curl, CURLOPT_TIMECONDITION, modified_since ? CURL_TIMECOND_IFMODSINCE : CURL_TIMECOND_NONE);
+    curl_easy_setopt(curl, CURLOPT_TIMEVALUE,     (long)modified_since);
     res_code = curl_easy_perform(curl);
 
     if (res_code != CURLE_OK) {
-        if (chunk.data) {
-            free(chunk.data);
+        free(chunk->data);
+        chunk->data = NULL;
+
+        if (res_code == CURLE_ABORTED_BY_CALLBACK) {
+            error_set(TTT_ERROR_REQUEST_CANCELLED);
+        } else {
+            error_set_with_string(TTT_ERROR_REQUEST_FAILED, curl_easy_strerror(res_code));
         }
 
-        error_set_with_string(TTT_ERROR_REQUEST_FAILED, curl_easy_strerror(res_code));
+        return false;
+    }
+
+    trace_request(curl, start, chunk->size);
+    long unmet = 0;
+    curl_easy_getinfo(curl, CURLINFO_CONDITION_UNMET, &unmet);
+
+    // The server responded with "304 Not Modified", which is not an error
+    if (unmet) {
+        free(chunk->data);
+        chunk->data = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+/// @brief Initializes curl, once before any other threads are started. Every
+///        thread creates its own handle with its first request.
+void api_initialize() {
+    if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK) {
+        printf("Failed to initialize curl");
+        exit(1);
+    }
+}
+
+/// @brief Sets a function that is called regularly during the requests of the calling
+///        thread, that can cancel a request that is no longer needed, e.g. after the user
+///        has moved on. libcurl calls it at least once per second, and more often while
+///        receiving data.
+void api_set_cancel_check(api_cancel_check_t check) {
+    cancel_check = check;
+}
+
+page_t *api_get_page(uint16_t page_id) {
+    response_chunk_t chunk;
+
+    if (!make_request(page_id, 0, 0, &chunk)) {
         return NULL;
     }
 
+    trace_begin("parse", page_id);
     page_t *page = parser_get_page(chunk.data, chunk.size);
+    trace_end("parse", page_id);
     free(chunk.data);
     return page;
 }
 
-void api_initialize() {
-    curl_global_init(CURL_GLOBAL_DEFAULT);
-    curl = curl_easy_init();
+/// @brief Fetches a page with a conditional request, i.e. the server only sends
+///        the page if it has been updated since 'unix_date'
+/// @return the page or NULL if it has not been modified (no error is set) or if the request failed
+page_t *api_get_page_if_modified(uint16_t page_id, uint64_t unix_date) {
+    response_chunk_t chunk;
 
-    if (!curl) {
-        printf("Failed to initialize curl");
-        exit(1);
+    if (!make_request(page_id, 0, unix_date, &chunk)) {
+        return NULL;
     }
+
+    trace_begin("parse", page_id);
+    page_t *page = parser_get_page(chunk.data, chunk.size);
+    trace_end("parse", page_id);
+    free(chunk.data);
+    return page;
 }
 
-page_t *api_get_page(uint16_t page_id) {
-    return make_request(page_id, 0);
+/// @brief Fetches every page between start and end (inclusive) with a single request.
+///        Pages that do not exist are not included.
+page_collection_t *api_get_page_range(uint16_t start, uint16_t end) {
+    response_chunk_t chunk;
+
+    if (!make_request(start, end, 0, &chunk)) {
+        return NULL;
+    }
+
+    trace_begin("parse", start);
+    page_collection_t *pages = parser_get_page_collection(chunk.data, chunk.size);
+    trace_end("parse", start);
+    free(chunk.data);
+    return pages;
+}
+
+/// @brief Fetches every page between start and end (inclusive) with a single request, without
+///        parsing the response, e.g. to store the pages as they were received
+/// @return the response, which must be free'd by the caller, or NULL if the request failed
+char *api_get_page_range_data(uint16_t start, uint16_t end, size_t *size) {
+    response_chunk_t chunk;
+
+    if (!make_request(start, end, 0, &chunk)) {
+        return NULL;
+    }
+
+    *size = chunk.size;
+    return chunk.data;
+}
+
+/// @brief Frees the handle of a thread that is done making requests
+void api_thread_destroy() {
+    curl_easy_cleanup(curl);
+    curl = NULL;
 }
 
 void api_destroy() {
@@ -116,6 +243,6 @@ void api_destroy() {
     // This seems to be a known issue (?)
     // https://stackoverflow.com/questions/11494950/memory-leak-from-curl-library
     // The errors in 'memtest' are hidden using a valrind suppression file.
-    curl_easy_cleanup(curl);
+    api_thread_destroy();
     curl_global_cleanup();
 }
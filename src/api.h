@@ -1,5 +1,6 @@
 #pragma once
 #include <stdint.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
@@ -8,6 +9,7 @@
 #include "shared.h"
 #include "parser.h"
 #include "errors.h"
+#include "trace.h"
 
 typedef enum api_pages {
     TTT_PAGE_HOME = 100,
@@ -21,6 +23,14 @@ typedef enum api_pages {
     TTT_PAGE_CONTENTS = 700
 } api_pages_t;
 
+/// @brief Returns true if the current request is no longer needed
+typedef bool (*api_cancel_check_t)();
+
 void api_initialize();
+void api_set_cancel_check(api_cancel_check_t check);
 page_t *api_get_page(uint16_t page);
+page_t *api_get_page_if_modified(uint16_t page, uint64_t unix_date);
+page_collection_t *api_get_page_range(uint16_t start, uint16_t end);
+char *api_get_page_range_data(uint16_t start, uint16_t end, size_t *size);
+void api_thread_destroy();
 void api_destroy();
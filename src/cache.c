@@ -0,0 +1,231 @@
+#include "cache.h"
+
+typedef struct cache_entry {
+    page_t *page;
+    unsigned int pins;
+    uint64_t last_used;
+    bool indexed;               // false if the page has been replaced but is still pinned
+} cache_entry_t;
+
+// Owns the cached pages. Pages are looked up by id in a table that is indexed
+// directly by the page id, and the least recently used page that is not pinned
+// is destroyed when there are more pages than the capacity.
+struct page_cache {
+    cache_entry_t *entries;
+    size_t entry_count;
+    size_t entry_capacity;
+    size_t indexed_count;
+    size_t capacity;
+    uint64_t clock;
+    int index[CACHE_MAX_PAGE_ID + 1];
+};
+
+static bool is_valid_id(uint16_t id) {
+    return id <= CACHE_MAX_PAGE_ID;
+}
+
+static int find_entry(page_cache_t *cache, page_t *page) {
+    if (!page) {
+        return CACHE_NO_ENTRY;
+    }
+
+    // Check the index first since most pinned pages are still indexed
+    if (is_valid_id(page->id)) {
+        int entry = cache->index[page->id];
+
+        if (entry != CACHE_NO_ENTRY && cache->entries[entry].page == page) {
+            return entry;
+        }
+    }
+
+    for (size_t i = 0; i < cache->entry_count; i++) {
+        if (cache->entries[i].page == page) {
+            return i;
+        }
+    }
+
+    return CACHE_NO_ENTRY;
+}
+
+/// @brief Destroys the page of an entry and moves the last entry into its place
+static void remove_entry(page_cache_t *cache, int entry) {
+    cache_entry_t *removed = &cache->entries[entry];
+
+    if (removed->indexed) {
+        cache->index[removed->page->id] = CACHE_NO_ENTRY;
+        cache->indexed_count--;
+    }
+
+    page_destroy(removed->page);
+    cache->entry_count--;
+
+    if (entry == cache->entry_count) {
+        return;
+    }
+
+    cache->entries[entry] = cache->entries[cache->entry_count];
+
+    if (cache->entries[entry].indexed) {
+        cache->index[cache->entries[entry].page->id] = entry;
+    }
+}
+
+/// @brief Evicts the least recently used pages that are not pinned
+/// @param keep a page that should not be evicted even if it is not pinned, e.g. a page that was just added
+static void evict(page_cache_t *cache, page_t *keep) {
+    while (cache->indexed_count > cache->capacity) {
+        int oldest = CACHE_NO_ENTRY;
+
+        for (size_t i = 0; i < cache->entry_count; i++) {
+            cache_entry_t *entry = &cache->entries[i];
+
+            if (!entry->indexed || entry->pins > 0 || entry->page == keep) {
+                continue;
+            }
+
+            if (oldest == CACHE_NO_ENTRY || entry->last_used < cache->entries[oldest].last_used) {
+                oldest = i;
+            }
+        }
+
+        // Everything is pinned, the cache is allowed to grow until something is unpinned
+        if (oldest == CACHE_NO_ENTRY) {
+            return;
+        }
+
+        remove_entry(cache, oldest);
+    }
+}
+
+/// @brief Creates a cache that holds at most 'capacity' pages that are not pinned
+page_cache_t *cache_create(size_t capacity) {
+    page_cache_t *cache = calloc(1, sizeof(page_cache_t));
+
+    if (!cache) {
+        error_set(TTT_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    cache->capacity = capacity;
+
+    for (int i = 0; i <= CACHE_MAX_PAGE_ID; i++) {
+        cache->index[i] = CACHE_NO_ENTRY;
+    }
+
+    return cache;
+}
+
+/// @brief Returns the cached page with the id and marks it as recently used
+/// @return the page or NULL if it is not cached
+page_t *cache_get(page_cache_t *cache, uint16_t id) {
+    if (!cache || !is_valid_id(id) || cache->index[id] == CACHE_NO_ENTRY) {
+        return NULL;
+    }
+
+    cache_entry_t *entry = &cache->entries[cache->index[id]];
+    entry->last_used = ++cache->clock;
+    return entry->page;
+}
+
+/// @brief Checks if a page is cached without marking it as recently used
+bool cache_contains(page_cache_t *cache, uint16_t id) {
+    return cache && is_valid_id(id) && cache->index[id] != CACHE_NO_ENTRY;
+}
+
+/// @brief Gets a cached page without marking it as recently used
+page_t *cache_peek(page_cache_t *cache, uint16_t id) {
+    return cache_contains(cache, id) ? cache->entries[cache->index[id]].page : NULL;
+}
+
+/// @brief Adds a page to the cache, which takes ownership of it. A cached page
+///        with the same id is replaced, but not destroyed until it has been unpinned.
+/// @return false if the page could not be cached, the caller still owns the page
+bool cache_put(page_cache_t *cache, page_t *page) {
+    if (!cache || !page || !is_valid_id(page->id)) {
+        return false;
+    }
+
+    if (cache->entry_count == cache->entry_capacity) {
+        size_t new_capacity = cache->entry_capacity ? cache->entry_capacity * 2 : 16;
+        cache_entry_t *entries = realloc(cache->entries, new_capacity * sizeof(cache_entry_t));
+
+        if (!entries) {
+            error_set(TTT_ERROR_OUT_OF_MEMORY);
+            return false;
+        }
+
+        cache->entries = entries;
+        cache->entry_capacity = new_capacity;
+    }
+
+    int previous = cache->index[page->id];
+
+    if (previous != CACHE_NO_ENTRY) {
+        if (cache->entries[previous].pins > 0) {
+            cache->entries[previous].indexed = false;
+            cache->indexed_count--;
+        } else {
+            remove_entry(cache, previous);
+        }
+    }
+
+    cache->entries[cache->entry_count] = (cache_entry_t) {
+        .page = page,
+        .pins = 0,
+        .last_used = ++cache->clock,
+        .indexed = true
+    };
+    cache->index[page->id] = cache->entry_count;
+    cache->entry_count++;
+    cache->indexed_count++;
+    evict(cache, page);
+    return true;
+}
+
+/// @brief Keeps a cached page from being destroyed, e.g. while it is displayed
+void cache_pin(page_cache_t *cache, page_t *page) {
+    int entry = cache ? find_entry(cache, page) : CACHE_NO_ENTRY;
+
+    if (entry != CACHE_NO_ENTRY) {
+        cache->entries[entry].pins++;
+    }
+}
+
+void cache_unpin(page_cache_t *cache, page_t *page) {
+    int entry = cache ? find_entry(cache, page) : CACHE_NO_ENTRY;
+
+    if (entry == CACHE_NO_ENTRY || cache->entries[entry].pins == 0) {
+        return;
+    }
+
+    cache->entries[entry].pins--;
+
+    if (cache->entries[entry].pins > 0) {
+        return;
+    }
+
+    if (!cache->entries[entry].indexed) {
+        // The page has been replaced
+        remove_entry(cache, entry);
+    } else {
+        evict(cache, NULL);
+    }
+}
+
+/// @brief Returns the number of pages that can be looked up in the cache
+size_t cache_get_size(page_cache_t *cache) {
+    return cache ? cache->indexed_count : 0;
+}
+
+void cache_destroy(page_cache_t *cache) {
+    if (!cache) {
+        return;
+    }
+
+    for (size_t i = 0; i < cache->entry_count; i++) {
+        page_destroy(cache->entries[i].page);
+    }
+
+    free(cache->entries);
+    free(cache);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "pages.h"
+#include "errors.h"
+
+// Teletext pages are numbered 100-999, see the 3 digit limit in the UI
+#define CACHE_MAX_PAGE_ID  999
+#define CACHE_NO_ENTRY     -1
+
+typedef struct page_cache page_cache_t;
+
+page_cache_t *cache_create(size_t capacity);
+page_t *cache_get(page_cache_t *cache, uint16_t id);
+bool cache_contains(page_cache_t *cache, uint16_t id);
+page_t *cache_peek(page_cache_t *cache, uint16_t id);
+bool cache_put(page_cache_t *cache, page_t *page);
+void cache_pin(page_cache_t *cache, page_t *page);
+void cache_unpin(page_cache_t *cache, page_t *page);
+size_t cache_get_size(page_cache_t *cache);
+void cache_destroy(page_cache_t *cache);
@@ -1,5 +1,72 @@
 #include "colors.h"
 
+// Color pair for every combination of foreground and background color
+static attr_t color_pair_table[COLORS_FG_COUNT][COLORS_BG_COUNT];
+
+static const short fg_colors[COLORS_FG_COUNT] = {
+    [PAGE_TOKEN_ATTR_BLUE - PAGE_TOKEN_ATTR_FG_FIRST] = COLOR_BLUE,
+    [PAGE_TOKEN_ATTR_CYAN - PAGE_TOKEN_ATTR_FG_FIRST] = COLOR_CYAN,
+    [PAGE_TOKEN_ATTR_WHITE - PAGE_TOKEN_ATTR_FG_FIRST] = COLOR_WHITE,
+    [PAGE_TOKEN_ATTR_GREEN - PAGE_TOKEN_ATTR_FG_FIRST] = COLOR_GREEN,
+    [PAGE_TOKEN_ATTR_YELLOW - PAGE_TOKEN_ATTR_FG_FIRST] = COLOR_YELLOW,
+    [PAGE_TOKEN_ATTR_RED - PAGE_TOKEN_ATTR_FG_FIRST] = COLOR_RED
+};
+
+static const short bg_colors[COLORS_BG_COUNT] = {
+    [PAGE_TOKEN_ATTR_BG_BLACK - PAGE_TOKEN_ATTR_BG_FIRST] = COLOR_BLACK,
+    [PAGE_TOKEN_ATTR_BG_BLUE - PAGE_TOKEN_ATTR_BG_FIRST] = COLOR_BLUE,
+    [PAGE_TOKEN_ATTR_BG_CYAN - PAGE_TOKEN_ATTR_BG_FIRST] = COLOR_CYAN,
+    [PAGE_TOKEN_ATTR_BG_WHITE - PAGE_TOKEN_ATTR_BG_FIRST] = COLOR_WHITE,
+    [PAGE_TOKEN_ATTR_BG_GREEN - PAGE_TOKEN_ATTR_BG_FIRST] = COLOR_GREEN,
+    [PAGE_TOKEN_ATTR_BG_YELLOW - PAGE_TOKEN_ATTR_BG_FIRST] = COLOR_YELLOW,
+    [PAGE_TOKEN_ATTR_BG_RED - PAGE_TOKEN_ATTR_BG_FIRST] = COLOR_RED
+};
+
+/// @brief Returns the color of text on a background, which is only changed when
+///        the text would have the same color as the background
+static short get_readable_color(short fg, short bg) {
+    if (fg != bg) {
+        return fg;
+    }
+
+    switch (bg) {
+    case COLOR_YELLOW:
+        return COLOR_BLUE;
+
+    case COLOR_BLUE:
+        return COLOR_YELLOW;
+
+    case COLOR_RED:
+        return COLOR_WHITE;
+
+    default:
+        return COLOR_BLACK;
+    }
+}
+
+/// @brief Creates a color pair for every style once, so that no conditionals have
+///        to be evaluated when the pages are drawn
+/// @param background_color the color of the default background, -1 for the terminal's own
+static void create_color_pair_table(bool overwrite_colors, short background_color) {
+    for (int fg = 0; fg < COLORS_FG_COUNT; fg++) {
+        for (int bg = 0; bg < COLORS_BG_COUNT; bg++) {
+            short pair = COLORSCHEME_TABLE_FIRST + fg * COLORS_BG_COUNT + bg;
+            short text = get_readable_color(fg_colors[fg], bg_colors[bg]);
+
+            // The colors of the terminal might not have enough contrast, see 'colors_initialize()'
+            if (!overwrite_colors && bg_colors[bg] != COLOR_BLACK) {
+                text = COLOR_BLACK;
+            }
+
+            if (pair >= COLOR_PAIRS || init_pair(pair, text, bg_colors[bg] == COLOR_BLACK ? background_color : bg_colors[bg]) == ERR) {
+                color_pair_table[fg][bg] = COLOR_PAIR(COLORSCHEME_DEFAULT);
+            } else {
+                color_pair_table[fg][bg] = COLOR_PAIR(pair);
+            }
+        }
+    }
+}
+
 void colors_initialize(bool overwrite_colors, bool transparent_background) {
     short background_color = COLOR_BLACK;
     start_color();
@@ -20,7 +87,6 @@ void colors_initialize(bool overwrite_colors, bool transparent_background) {
         init_pair(COLORSCHEME_WBL,      COLOR_WHITE,    COLOR_BLUE);
         init_pair(COLORSCHEME_YBL,      COLOR_YELLOW,   COLOR_BLUE);
         init_pair(COLORSCHEME_BLY,      COLOR_BLUE,     COLOR_YELLOW);
-        init_pair(COLORSCHEME_WR,       COLOR_WHITE,    COLOR_RED);
     } else {
         use_default_colors();
         // Assume that the colors does not have sufficient contrast
@@ -30,7 +96,6 @@ void colors_initialize(bool overwrite_colors, bool transparent_background) {
         init_pair(COLORSCHEME_WBL,      COLOR_BLACK,    COLOR_BLUE);
         init_pair(COLORSCHEME_YBL,      COLOR_BLACK,    COLOR_BLUE);
         init_pair(COLORSCHEME_BLY,      COLOR_BLACK,    COLOR_YELLOW);
-        init_pair(COLORSCHEME_WR,       COLOR_BLACK,    COLOR_RED);
     }
 
     if (transparent_background) {
@@ -41,30 +106,43 @@ void colors_initialize(bool overwrite_colors, bool transparent_background) {
     // Shared colorschemes
     init_pair(COLORSCHEME_DEFAULT,  COLOR_WHITE,    background_color);
     init_pair(COLORSCHEME_YX,       COLOR_YELLOW,   background_color);
-    init_pair(COLORSCHEME_CX,       COLOR_CYAN,     background_color);
-    init_pair(COLORSCHEME_RX,       COLOR_RED,      background_color);
+    create_color_pair_table(overwrite_colors, background_color);
 }
 
 attr_t colors_get_color_pair_from_style(page_token_style_t style) {
-    if (
-        (style.fg == PAGE_TOKEN_ATTR_YELLOW && style.bg == PAGE_TOKEN_ATTR_BG_YELLOW) ||
-        (style.fg == PAGE_TOKEN_ATTR_BLUE && style.bg == PAGE_TOKEN_ATTR_BG_YELLOW)
-    ) {
-        return COLOR_PAIR(COLORSCHEME_BLY);
-    } else if (
-        (style.fg == PAGE_TOKEN_ATTR_BLUE || style.fg == PAGE_TOKEN_ATTR_YELLOW) &&
-        (style.bg == PAGE_TOKEN_ATTR_BG_BLUE)
-    ) {
-        return COLOR_PAIR(COLORSCHEME_YBL);
-    } else if (style.fg == PAGE_TOKEN_ATTR_CYAN && style.bg == PAGE_TOKEN_ATTR_BG_BLACK) {
-        return COLOR_PAIR(COLORSCHEME_CX);
-    } else if (style.fg == PAGE_TOKEN_ATTR_YELLOW && style.bg == PAGE_TOKEN_ATTR_BG_BLACK) {
-        return COLOR_PAIR(COLORSCHEME_YX);
-    } else if (style.fg == PAGE_TOKEN_ATTR_WHITE && style.bg == PAGE_TOKEN_ATTR_BG_BLUE) {
-        return COLOR_PAIR(COLORSCHEME_WBL);
-    } else if (style.fg == PAGE_TOKEN_ATTR_RED && style.bg == PAGE_TOKEN_ATTR_BG_RED) {
-        return COLOR_PAIR(COLORSCHEME_WR);
-    } else {
+    int fg = style.fg - PAGE_TOKEN_ATTR_FG_FIRST;
+    int bg = style.bg - PAGE_TOKEN_ATTR_BG_FIRST;
+
+    if (fg < 0 || fg >= COLORS_FG_COUNT || bg < 0 || bg >= COLORS_BG_COUNT) {
         return COLOR_PAIR(COLORSCHEME_DEFAULT);
     }
+
+    return color_pair_table[fg][bg];
+}
+
+attr_t colors_get_token_attr(page_token_t *token) {
+    attr_t attr = colors_get_color_pair_from_style(token->style);
+
+    if (token->style.extra != PAGE_TOKEN_ATTR_NONE) {
+        attr |= A_BOLD;
+    }
+
+    if (token->type == PAGE_TOKEN_LINK) {
+        attr |= A_UNDERLINE;
+    }
+
+    return attr;
+}
+
+/// @brief Stores the display attributes in every token of the page that has not been resolved yet
+void colors_resolve_page(page_t *page) {
+    if (!page) {
+        return;
+    }
+
+    for (page_token_t *cursor = page_get_tokens(page); cursor; cursor = cursor->next) {
+        if (cursor->attr == 0) {
+            cursor->attr = colors_get_token_attr(cursor);
+        }
+    }
 }
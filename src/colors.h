@@ -13,10 +13,14 @@ typedef enum colorschemes {
     COLORSCHEME_BLY,        // BLUE-YELLOW
     COLORSCHEME_YBL,        // YELLOW-BLUE
     COLORSCHEME_YX,         // YELLOW-DEFAULT
-    COLORSCHEME_CX,         // CYAN-DEFAULT
-    COLORSCHEME_WR,         // WHITE-RED
-    COLORSCHEME_RX,         // RED-BLACK
+    COLORSCHEME_TABLE_FIRST // the pairs of the styles of the pages, see 'colors_get_color_pair_from_style()'
 } colorschemes_t;
 
+#define COLORS_FG_COUNT (PAGE_TOKEN_ATTR_FG_LAST - PAGE_TOKEN_ATTR_FG_FIRST + 1)
+#define COLORS_BG_COUNT (PAGE_TOKEN_ATTR_BG_LAST - PAGE_TOKEN_ATTR_BG_FIRST + 1)
+#define COLORS_PAIR_COUNT (COLORSCHEME_TABLE_FIRST + COLORS_FG_COUNT * COLORS_BG_COUNT)
+
 void colors_initialize(bool overwrite_colors, bool transparent_background);
 attr_t colors_get_color_pair_from_style(page_token_style_t style);
+attr_t colors_get_token_attr(page_token_t *token);
+void colors_resolve_page(page_t *page);
@@ -0,0 +1,151 @@
+#include "crawler.h"
+
+typedef struct crawl {
+    page_store_t *store;
+    search_index_t *index;
+    crawler_progress_t progress;
+    uint64_t start_ms;
+    crawler_progress_callback_t callback;
+    void *data;
+} crawl_t;
+
+// The crawl that the workers are running, one range at a time, see 'crawler_start()'
+static crawl_t running_crawl;
+static worker_job_t *range_job = NULL;
+static uint16_t next_id = 0;
+static bool running = false;
+static bool stopped = false;
+
+static uint64_t get_time_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static void update_progress(crawl_t *crawl, uint16_t start, uint16_t end) {
+    crawler_progress_t *progress = &crawl->progress;
+    progress->done += end - start + 1;
+    progress->elapsed_ms = get_time_ms() - crawl->start_ms;
+    progress->remaining_ms = progress->elapsed_ms * (progress->total - progress->done) / progress->done;
+}
+
+/// @brief Calls the callback for the last time, with the error set if the crawl did not complete
+static void finish_crawl() {
+    crawler_progress_t *progress = &running_crawl.progress;
+    running = false;
+    progress->finished = true;
+
+    if (stopped) {
+        error_set(TTT_ERROR_REQUEST_CANCELLED);
+    } else if (progress->pages == 0 && !error_is_set()) {
+        error_set(TTT_ERROR_REQUEST_FAILED);
+    }
+
+    running_crawl.callback(progress, running_crawl.data);
+    error_reset();
+}
+
+static void handle_range_job(worker_job_t *job);
+
+static bool submit_next_range() {
+    uint16_t end = next_id + CRAWLER_RANGE_SIZE - 1;
+
+    if (end > CRAWLER_LAST_PAGE) {
+        end = CRAWLER_LAST_PAGE;
+    }
+
+    range_job = workers_create_job(WORKER_JOB_CRAWL_RANGE, next_id, end, handle_range_job, NULL);
+
+    if (!range_job) {
+        return false;
+    }
+
+    // The pages are indexed as they arrive, so the worker parses them
+    range_job->store = running_crawl.store;
+    atomic_store(&range_job->tokenize, running_crawl.index != NULL);
+    next_id = end + 1;
+    workers_submit(range_job, SCHEDULER_PRIORITY_CRAWL);
+    return true;
+}
+
+static void handle_range_job(worker_job_t *job) {
+    crawler_progress_t *progress = &running_crawl.progress;
+    range_job = NULL;
+
+    if (job->pages) {
+        progress->pages += job->pages->size;
+
+        for (size_t i = 0; running_crawl.index && i < job->pages->size; i++) {
+            search_add_page(running_crawl.index, job->pages->pages[i]);
+        }
+
+        // Pages that can not be parsed are still stored, only their errors are dropped
+        error_reset();
+    }
+
+    if (stopped) {
+        finish_crawl();
+        return;
+    }
+
+    if (!job->pages) {
+        progress->failed_ranges++;
+    }
+
+    update_progress(&running_crawl, job->start, job->end);
+
+    if (progress->done == progress->total || !submit_next_range()) {
+        finish_crawl();
+        return;
+    }
+
+    running_crawl.callback(progress, running_crawl.data);
+}
+
+/// @brief Starts fetching every page, CRAWLER_FIRST_PAGE to CRAWLER_LAST_PAGE, and storing
+///        them so that they can be shown offline. Each range of pages is a job for the
+///        workers with SCHEDULER_PRIORITY_CRAWL, so the crawl is rate limited and makes
+///        way for the pages that the user is waiting for. The pages are added to the
+///        search index as they arrive, by the thread that handles the completed jobs.
+/// @param index the search index or NULL
+/// @param callback called by 'workers_handle_completed()' after each range with the progress
+///        so far, and once more when the crawl is over, see 'crawler_progress_t'
+/// @return false if the crawl could not be started, e.g. since one is already running
+bool crawler_start(page_store_t *store, search_index_t *index, crawler_progress_callback_t callback, void *data) {
+    if (!store) {
+        error_set(TTT_ERROR_STORE_FAILED);
+        return false;
+    }
+
+    if (running) {
+        return false;
+    }
+
+    running_crawl = (crawl_t){
+        .store = store,
+        .index = index,
+        .progress = {
+            .total = CRAWLER_LAST_PAGE - CRAWLER_FIRST_PAGE + 1
+        },
+        .start_ms = get_time_ms(),
+        .callback = callback,
+        .data = data
+    };
+    next_id = CRAWLER_FIRST_PAGE;
+    stopped = false;
+    running = submit_next_range();
+    return running;
+}
+
+/// @brief Stops the crawl, the callback is called for the last time once the range
+///        that is being fetched has been cancelled
+void crawler_stop() {
+    if (running && !stopped) {
+        stopped = true;
+        workers_cancel(range_job);
+    }
+}
+
+bool crawler_is_running() {
+    return running;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "api.h"
+#include "store.h"
+#include "search.h"
+#include "parser.h"
+#include "errors.h"
+#include "workers.h"
+
+#define CRAWLER_FIRST_PAGE   100
+#define CRAWLER_LAST_PAGE    899
+#define CRAWLER_RANGE_SIZE   20
+
+typedef struct crawler_progress {
+    uint16_t done;              // the number of page numbers that have been fetched
+    uint16_t total;
+    size_t pages;               // the number of pages that exist and have been stored
+    size_t failed_ranges;
+    uint64_t elapsed_ms;
+    uint64_t remaining_ms;      // estimated from the time so far
+    bool finished;              // the crawl is over, the error is set if it did not complete
+} crawler_progress_t;
+
+typedef void (*crawler_progress_callback_t)(crawler_progress_t *progress, void *data);
+
+bool crawler_start(page_store_t *store, search_index_t *index, crawler_progress_callback_t callback, void *data);
+void crawler_stop();
+bool crawler_is_running();
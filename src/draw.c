@@ -1,80 +1,111 @@
 #include "draw.h"
 
-#define MAX_PAGE_LINKS 32
-
-// Stores the position and length of a clickable link
-typedef struct {
-    int x, y;
-    page_token_t *token;
-} link_t;
+#define MAX_SEARCH_MATCHES 64
 
 static view_t current_view;
+static draw_backend_t backend = DRAW_BACKEND_CURSES;
 
+// The links of the page in the main view
+static page_grid_t *current_grid = NULL;
 static int current_link = -1;
 static int current_link_count = 0;
-static link_t rendered_links[MAX_PAGE_LINKS];
+
+// The frame of the current view without any highlighting, the frame
+// that we want to show and the frame that is currently visible.
+static frame_t base_frame;
+static frame_t next_frame;
+static frame_t shown_frame;
+static bool base_frame_valid = false;
+static bool shown_frame_valid = false;
+static bool defer_frames = false;
+static WINDOW *deferred_win = NULL;
+static page_t *bytes_page = NULL;
+static uint64_t page_bytes = 0;
+static bool error_line_dirty = false;
+static frame_t help_frame;
+static bool help_frame_valid = false;
+
+// The words of a search that are highlighted on the page with the hit
+typedef struct search_match {
+    int line, col;
+    size_t length;
+} search_match_t;
+
+static uint16_t search_page_id = 0;
+static char search_words[SEARCH_MAX_WORDS][SEARCH_WORD_SIZE];
+static size_t search_word_count = 0;
+static search_match_t search_matches[MAX_SEARCH_MATCHES];
+static int search_match_count = 0;
 
 static bool is_valid_link_index(int link_index) {
     return link_index != -1 && current_link_count > 0 && link_index < current_link_count;
 }
 
-static void save_rendered_link(WINDOW *win, page_token_t *token) {
-    if (current_link_count >= MAX_PAGE_LINKS - 1) {
+/// @brief Shows the base frame with the current link highlighted,
+///        only writing the cells that have changed since the last frame
+static void present(WINDOW *win) {
+    if (defer_frames) {
+        // Another frame will replace this one, only show the latest one
+        deferred_win = win;
         return;
     }
 
-    getyx(win, rendered_links[current_link_count].y, rendered_links[current_link_count].x);
-    rendered_links[current_link_count].token = token;
-    current_link_count++;
-}
-
-static void terminate_rendered_link_list() {
-    rendered_links[current_link].token = NULL;
-}
-
-static void draw_token(WINDOW *win, page_token_t *token, bool save_link) {
-    attr_t style = colors_get_color_pair_from_style(token->style);
-
-    if (token->style.extra != -1) {
-        style |= A_BOLD;
-    }
-
-    if (token->type == PAGE_TOKEN_LINK) {
-        style |= A_UNDERLINE;
+    deferred_win = NULL;
+    uint64_t bytes_before = output_get_bytes_written();
+    memcpy(&next_frame, &base_frame, sizeof(frame_t));
 
-        if (save_link) {
-            save_rendered_link(win, token);
+    if (current_view == VIEW_MAIN) {
+        for (int i = 0; i < search_match_count; i++) {
+            search_match_t *match = &search_matches[i];
+            frame_set_attr(&next_frame, match->line, match->col, match->length, COLOR_PAIR(COLORSCHEME_BLY) | A_BOLD);
         }
     }
 
-    wattron(win, style);
+    if (current_view == VIEW_MAIN && is_valid_link_index(current_link)) {
+        page_link_t *current = grid_get_link(current_grid, current_link);
+        frame_set_attr(
+            &next_frame,
+            current->line,
+            current->col,
+            current->length,
+            COLOR_PAIR(COLORSCHEME_BW) | A_BOLD | A_UNDERLINE
+        );
+    }
 
-    if (token->text) {
-        wprintw(win, token->text);
+    if (backend == DRAW_BACKEND_ANSI) {
+        int origin_line, origin_col;
+        getbegyx(win, origin_line, origin_col);
+        // Let curses think that the window is up to date, so that it never
+        // overwrites the page, and flush any pending curses output first.
+        wnoutrefresh(win);
+        doupdate();
+        ansi_present(&shown_frame, &next_frame, origin_line, origin_col, !shown_frame_valid);
+    } else {
+        frame_present(win, &shown_frame, &next_frame, !shown_frame_valid);
+        doupdate();
     }
 
-    wattroff(win, style);
+    shown_frame_valid = true;
+    page_bytes += output_get_bytes_written() - bytes_before;
 }
 
-static void dehighlight_link(WINDOW *win) {
-    assert(current_link >= 0);
-    assert(current_link < MAX_PAGE_LINKS);
-    link_t current = rendered_links[current_link];
-    wmove(win, current.y, current.x);
-    draw_token(win, current.token, false);
-    wrefresh(win);
+static void clear_error() {
+    if (!error_line_dirty) {
+        return;
+    }
+
+    move(LINES - 1, 0);
+    clrtoeol();
+    wnoutrefresh(stdscr);
+    error_line_dirty = false;
 }
 
-static void highlight_link(WINDOW *win) {
-    assert(current_link >= 0);
-    assert(current_link < MAX_PAGE_LINKS);
-    link_t current = rendered_links[current_link];
-    wmove(win, current.y, current.x);
-    attr_t style = COLOR_PAIR(COLORSCHEME_BW);
-    wattron(win, style | A_BOLD | A_UNDERLINE);
-    waddnstr(win, current.token->text, current.token->length);
-    wattroff(win, style | A_BOLD | A_UNDERLINE);
-    wrefresh(win);
+static void print_error(const char *str) {
+    // Errors can follow each other without a page being drawn in between
+    clear_error();
+    mvaddstr(LINES - 1, 1, str);
+    wnoutrefresh(stdscr);
+    error_line_dirty = true;
 }
 
 /// @brief Prints a T in a 3x3 box
@@ -187,7 +218,7 @@ uint16_t draw_get_highlighted_link_href() {
         return 0;
     }
 
-    return rendered_links[current_link].token->href;
+    return grid_get_link(current_grid, current_link)->href;
 }
 
 int draw_get_highlighted_link_index() {
@@ -199,14 +230,8 @@ void draw_set_highlighted_link_index(WINDOW *win, int new_index) {
         return;
     }
 
-    if (current_link == -1) {
-        current_link = new_index;
-        highlight_link(win);
-    } else {
-        // Could make a new function for this, but it is easier to use the existing one
-        current_link = new_index - 1;
-        draw_next_link(win);
-    }
+    current_link = new_index;
+    present(win);
 }
 
 void draw_next_link(WINDOW *win) {
@@ -214,38 +239,59 @@ void draw_next_link(WINDOW *win) {
         return;
     }
 
-    if (current_link != -1 && current_link < current_link_count) {
-        dehighlight_link(win);
-    }
-
     if (current_link >= current_link_count - 1) {
         current_link = -1;
+    } else {
+        current_link++;
+    }
+
+    present(win);
+}
+
+void draw_move_link(WINDOW *win, link_direction_t direction) {
+    if (current_view != VIEW_MAIN || current_link_count == 0) {
         return;
     }
 
-    current_link++;
-    highlight_link(win);
+    if (current_link == -1) {
+        // Start from the top or the bottom of the page
+        bool backwards = direction == LINK_DIRECTION_UP || direction == LINK_DIRECTION_LEFT;
+        current_link = backwards ? current_link_count - 1 : 0;
+    } else {
+        int next = grid_get_link_neighbour(current_grid, current_link, direction);
+
+        if (next == GRID_NO_LINK) {
+            return;
+        }
+
+        current_link = next;
+    }
+
+    present(win);
 }
 
-void draw_previous_link(WINDOW *win) {
+int draw_get_link_at(int line, int col) {
     if (current_view != VIEW_MAIN) {
-        return;
+        return -1;
     }
 
-    if (current_link != -1) {
-        dehighlight_link(win);
+    return grid_get_link_at(current_grid, line, col);
+}
+
+void draw_previous_link(WINDOW *win) {
+    if (current_view != VIEW_MAIN) {
+        return;
     }
 
     if (current_link == 0) {
         current_link = -1;
-        return;
     } else if (current_link == -1) {
         current_link = current_link_count - 1;
     } else {
         current_link--;
     }
 
-    highlight_link(win);
+    present(win);
 }
 
 void draw_toggle_help(WINDOW *win, page_t *page) {
@@ -257,17 +303,30 @@ void draw_toggle_help(WINDOW *win, page_t *page) {
 }
 
 void draw_refresh_current(WINDOW *win, page_t *page) {
-    draw(win, current_view, page);
-}
+    if (!base_frame_valid) {
+        draw(win, current_view, page);
+        return;
+    }
 
+    // The terminal contents are lost when it is resized, but the frame is not,
+    // so it is shown again as it is without rendering it or losing the highlighted link
+    shown_frame_valid = false;
+    error_line_dirty = false;
+
+    if (current_view == VIEW_MAIN && error_is_set()) {
+        print_error(error_get_string());
+    }
+
+    present(win);
+}
 
 void draw_error(const char *str) {
     if (!str) {
         return;
     }
 
-    mvaddstr(LINES - 1, 1, str);
-    refresh();
+    print_error(str);
+    doupdate();
 }
 
 void draw_help(WINDOW *win) {
@@ -275,15 +334,17 @@ void draw_help(WINDOW *win) {
     print_toprow(win, &line, "0", "Keybindings");
     print_logo(win, &line);
     print_bold_title(win, &line, "Navigation");
-    print_keybinding(win, &line, "previous page", "h/p");
-    print_keybinding(win, &line, "select next link on page", "j");
-    print_keybinding(win, &line, "select previous link on page", "k");
-    print_keybinding(win, &line, "next page", "l/n");
-    print_keybinding(win, &line, "go back to previous page", "u/b");
+    // The page is full, combine keybindings that belong together
+    print_keybinding(win, &line, "previous/next page", "h/p, l/n");
+    print_keybinding(win, &line, "select next/previous link", "j/k");
+    print_keybinding(win, &line, "move between links", "arrow keys");
+    print_keybinding(win, &line, "go back/forward", "u/b, f");
+    print_keybinding(win, &line, "live updates of page", "r");
     print_keybinding(win, &line, "go to selected link", "enter");
-    print_keybinding(win, &line, "go to start page", "s");
-    print_keybinding(win, &line, "go to index page", "i");
+    print_keybinding(win, &line, "go to start/index page", "s/i");
     print_keybinding(win, &line, "go to page", ":<page-number>");
+    print_keybinding(win, &line, "select link by number", ":#<number>");
+    print_keybinding(win, &line, "search, next hit if empty", "/<words>");
     print_bold_title(win, &line, "General");
     print_keybinding(win, &line, "display (this) help page", "?");
     print_keybinding(win, &line, "quit", "q, :q, :Q");
@@ -323,46 +384,153 @@ void draw_command_message(WINDOW *win, char *str) {
     wrefresh(win);
 }
 
-void draw_main(WINDOW *win, page_t *page) {
-    if (error_is_set()) {
-        draw_error(error_get_string());
+static void render_help() {
+    // The help page never changes, so we only have to render it once
+    if (!help_frame_valid) {
+        WINDOW *pad = newpad(PAGE_LINES, PAGE_COLS);
+        wattrset(pad, COLOR_PAIR(COLORSCHEME_DEFAULT));
+
+        // Fill with empty characters to show the background color
+        for (int i = 0; i < PAGE_LINES * PAGE_COLS; i++) {
+            waddch(pad, ' ');
+        }
+
+        draw_help(pad);
+        frame_from_window(&help_frame, pad);
+        delwin(pad);
+        help_frame_valid = true;
     }
 
-    if (!page || !page->tokens) {
-        draw_empty_page(win);
+    memcpy(&base_frame, &help_frame, sizeof(frame_t));
+}
+
+static bool is_word_char(char c) {
+    return isalnum((unsigned char)c);
+}
+
+/// @brief Finds the words on the page that start with one of the searched words
+static void find_search_matches(page_t *page, page_grid_t *grid) {
+    search_match_count = 0;
+
+    if (!grid || !page || page->id != search_page_id) {
         return;
     }
 
-    page_token_t *cursor = page->tokens;
-    wmove(win, 0, 0);
+    char row[PAGE_COLS + 1];
+
+    for (int line = 0; line < PAGE_LINES; line++) {
+        grid_get_row_text(grid, line, row, sizeof(row));
+
+        for (int col = 0; col < PAGE_COLS && search_match_count < MAX_SEARCH_MATCHES; col++) {
+            if (!is_word_char(row[col]) || (col > 0 && is_word_char(row[col - 1]))) {
+                continue;
+            }
+
+            int length = 0;
+
+            while (col + length < PAGE_COLS && is_word_char(row[col + length])) {
+                length++;
+            }
+
+            for (size_t i = 0; i < search_word_count; i++) {
+                size_t word_length = strlen(search_words[i]);
+
+                if (word_length <= (size_t)length && strncasecmp(row + col, search_words[i], word_length) == 0) {
+                    search_matches[search_match_count] = (search_match_t) {
+                        .line = line,
+                        .col = col,
+                        .length = length
+                    };
+                    search_match_count++;
+                    break;
+                }
+            }
+
+            col += length;
+        }
+    }
+}
+
+/// @brief Highlights the words of a search on a page, until another page is shown
+void draw_set_search_highlight(uint16_t page_id, const char *query) {
+    search_page_id = page_id;
+    search_word_count = search_get_words(query, search_words);
+
+    if (bytes_page && current_grid) {
+        find_search_matches(bytes_page, current_grid);
+    }
+}
+
+/// @brief Sets up the links of the page and returns its grid
+static page_grid_t *select_page(page_t *page) {
+    if (page != bytes_page) {
+        bytes_page = page;
+        page_bytes = 0;
+    }
+
+    current_grid = NULL;
     current_link = -1;
     current_link_count = 0;
 
-    while (cursor) {
-        draw_token(win, cursor, true);
-        cursor = cursor->next;
+    // Pages are parsed the first time that they are drawn, which might fail
+    bool has_tokens = page_get_tokens(page) != NULL;
+
+    if (has_tokens && !page->grid) {
+        // Resolve the display attributes once, instead of every time the page is drawn
+        colors_resolve_page(page);
+    }
+
+    if (error_is_set()) {
+        print_error(error_get_string());
+    }
+
+    page_grid_t *grid = has_tokens ? grid_get(page) : NULL;
+
+    if (grid) {
+        current_grid = grid;
+        current_link_count = grid->link_count;
     }
 
-    terminate_rendered_link_list();
+    if (page && page->id != search_page_id) {
+        // The search is no longer relevant once the user has moved on
+        search_page_id = 0;
+    }
+
+    find_search_matches(page, grid);
+    return grid;
 }
 
-void draw(WINDOW *win, view_t view, page_t *page) {
-    clear();
-    wclear(win);
-    wattron(win, COLOR_PAIR(COLORSCHEME_DEFAULT));
+static void render_main(page_t *page) {
+    page_grid_t *grid = select_page(page);
 
-    // Fill with empty characters to show the background color
-    for (int i = 0; i < PAGE_LINES * PAGE_COLS; i++) {
-        waddch(win, ' ');
+    if (!grid) {
+        frame_clear(&base_frame, COLOR_PAIR(COLORSCHEME_DEFAULT));
+        frame_print(&base_frame, 0, 0, "Empty page!", COLOR_PAIR(COLORSCHEME_DEFAULT));
+        return;
     }
 
+    frame_t *frame = frame_cache_get(page);
+
+    if (!frame) {
+        frame = frame_cache_put(page);
+        frame_from_grid(frame, grid);
+    }
+
+    memcpy(&base_frame, frame, sizeof(frame_t));
+}
+
+void draw(WINDOW *win, view_t view, page_t *page) {
+    uint16_t page_id = page ? page->id : 0;
+    trace_begin("draw", page_id);
+    clear_error();
+
     switch (view) {
     case VIEW_MAIN:
-        draw_main(win, page);
+        render_main(page);
         break;
 
     case VIEW_HELP:
-        draw_help(win);
+        render_help();
         break;
 
     default:
@@ -370,9 +538,141 @@ void draw(WINDOW *win, view_t view, page_t *page) {
     }
 
     current_view = view;
-    wattroff(win, COLOR_PAIR(COLORSCHEME_DEFAULT));
-    refresh();
-    wrefresh(win);
+    base_frame_valid = true;
+    present(win);
+    trace_end("draw", page_id);
+}
+
+/// @brief Finds the link in the new grid that corresponds to a link in the old grid
+/// @return the link index or -1 if the link is no longer on the page
+static int find_same_link(page_grid_t *old_grid, int old_index, page_grid_t *grid) {
+    page_link_t *old_link = grid_get_link(old_grid, old_index);
+    int same_href = -1;
+
+    if (!old_link || !grid) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < grid->link_count; i++) {
+        page_link_t *link = &grid->links[i];
+
+        if (link->href != old_link->href) {
+            continue;
+        }
+
+        if (link->line == old_link->line && link->col == old_link->col) {
+            return i;
+        }
+
+        if (same_href == -1) {
+            same_href = i;
+        }
+    }
+
+    return same_href;
+}
+
+/// @brief Replaces the page in the main view with a newer version of it. Only the
+///        rows that have changed are rendered and written, and the highlighted link
+///        is kept if it is still on the page.
+/// @param old_page the page that is shown, which must not have been destroyed yet
+void draw_update(WINDOW *win, page_t *old_page, page_t *page) {
+    page_grid_t *old_grid = current_grid;
+    int old_link = current_link;
+
+    if (current_view != VIEW_MAIN || !base_frame_valid || !old_grid || bytes_page != old_page) {
+        // Only the main view shows the page, the help view shows it when it is closed
+        if (current_view == VIEW_MAIN) {
+            draw(win, VIEW_MAIN, page);
+        }
+
+        return;
+    }
+
+    // Keep counting the bytes of the page, it is the same page
+    bytes_page = page;
+    clear_error();
+    page_grid_t *grid = select_page(page);
+
+    if (!grid) {
+        draw(win, VIEW_MAIN, page);
+        return;
+    }
+
+    // The base frame still has the old page, only the changed rows are rendered
+    for (int line = 0; line < PAGE_LINES; line++) {
+        if (!grid_rows_equal(old_grid, line, grid, line)) {
+            frame_from_grid_row(&base_frame, grid, line);
+        }
+    }
+
+    frame_t *frame = frame_cache_put(page);
+
+    if (frame) {
+        memcpy(frame, &base_frame, sizeof(frame_t));
+    }
+
+    current_link = find_same_link(old_grid, old_link, grid);
+    present(win);
+}
+
+/// @brief Shows a page in the main view from a frame that it has been rendered
+///        to before, without rendering it again
+/// @param frame a frame from 'draw_copy_frame()' or NULL to render the page
+void draw_restore(WINDOW *win, page_t *page, frame_t *frame, int link_index) {
+    if (!frame) {
+        draw(win, VIEW_MAIN, page);
+        draw_set_highlighted_link_index(win, link_index);
+        return;
+    }
+
+    clear_error();
+    select_page(page);
+    memcpy(&base_frame, frame, sizeof(frame_t));
+    current_link = is_valid_link_index(link_index) ? link_index : -1;
+    current_view = VIEW_MAIN;
+    base_frame_valid = true;
+    present(win);
+}
+
+/// @brief Copies the page in the main view as it was rendered, without the highlighted link
+/// @return the frame, which is owned by the caller, or NULL if no page is shown
+frame_t *draw_copy_frame() {
+    if (current_view != VIEW_MAIN || !base_frame_valid) {
+        return NULL;
+    }
+
+    frame_t *frame = malloc(sizeof(frame_t));
+
+    if (frame) {
+        memcpy(frame, &base_frame, sizeof(frame_t));
+    }
+
+    return frame;
+}
+
+/// @brief Stops frames from being shown until 'draw_flush()' is called,
+///        e.g. to skip intermediate frames while a key is being held down
+void draw_set_deferred(bool deferred) {
+    defer_frames = deferred;
+}
+
+/// @brief Shows the latest frame if it has been deferred
+void draw_flush() {
+    if (!defer_frames && deferred_win) {
+        present(deferred_win);
+    }
+}
+
+void draw_set_backend(draw_backend_t new_backend) {
+    backend = new_backend;
+    shown_frame_valid = false;
+}
+
+/// @brief Returns the number of bytes written to the terminal to show
+///        the current page, from navigating to it until now
+uint64_t draw_get_page_bytes() {
+    return page_bytes;
 }
 
 int draw_get_current_view() {
@@ -1,25 +1,46 @@
 #pragma once
 #include <curses.h>
 #include <assert.h>
+#include <strings.h>
 
+#include "grid.h"
+#include "frame.h"
+#include "ansi.h"
+#include "trace.h"
+#include "output.h"
 #include "pages.h"
 #include "colors.h"
 #include "errors.h"
 #include "shared.h"
+#include "search.h"
 
 typedef enum view {
     VIEW_MAIN,
     VIEW_HELP
 } view_t;
 
+typedef enum draw_backend {
+    DRAW_BACKEND_CURSES,    // write pages through curses windows
+    DRAW_BACKEND_ANSI       // write pages directly to the terminal as escape sequences
+} draw_backend_t;
+
 void draw_error(const char *str);
 void draw_next_link(WINDOW *win);
 void draw_previous_link(WINDOW *win);
+void draw_move_link(WINDOW *win, link_direction_t direction);
 void draw_help(WINDOW *win);
 void draw_empty_page(WINDOW *win);
 void draw_toggle_help(WINDOW *win, page_t *page);
 void draw_refresh_current(WINDOW *win, page_t *page);
 void draw(WINDOW *win, view_t current, page_t *page);
+void draw_update(WINDOW *win, page_t *old_page, page_t *page);
+void draw_restore(WINDOW *win, page_t *page, frame_t *frame, int link_index);
+frame_t *draw_copy_frame();
+void draw_set_search_highlight(uint16_t page_id, const char *query);
+void draw_set_backend(draw_backend_t backend);
+void draw_set_deferred(bool deferred);
+void draw_flush();
+uint64_t draw_get_page_bytes();
 
 /// @brief Returns the page id of the currently highlighted link
 /// @return page id or 0 if no link is selected
@@ -27,6 +48,10 @@ uint16_t draw_get_highlighted_link_href();
 
 int draw_get_current_view();
 int draw_get_highlighted_link_index();
+
+/// @brief Returns the index of the link at a position in the page window
+/// @return link index or -1 if there is no link at the position
+int draw_get_link_at(int line, int col);
 void draw_set_highlighted_link_index(WINDOW *win, int new_index);
 
 void draw_command_start(WINDOW *win);
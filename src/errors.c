@@ -1,47 +1,62 @@
 #include "errors.h"
 
-static char *custom_error_string = NULL;
+// Every thread has its own error, so that the workers do not overwrite the errors
+// of the UI thread. The messages are kept in a fixed buffer, setting an error never allocates.
+static _Thread_local error_context_t current = {TTT_ERROR_NONE, ""};
 
 void error_set(ttt_error_t code) {
-    errno = code;
-
-    if (custom_error_string) {
-        free(custom_error_string);
-    }
-
-    custom_error_string = NULL;
+    current.code = code;
+    current.string[0] = '\0';
 }
 
+/// @brief Sets an error with a custom message, messages that are too long are truncated
 void error_set_with_string(ttt_error_t code, const char *str) {
-    errno = code;
+    current.code = code;
+    snprintf(current.string, ERROR_STRING_SIZE, "%s", str);
+}
 
-    if (custom_error_string) {
-        free(custom_error_string);
-    }
+/// @brief Sets an error with a printf-style custom message
+void error_set_with_format(ttt_error_t code, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    current.code = code;
+    vsnprintf(current.string, ERROR_STRING_SIZE, format, args);
+    va_end(args);
+}
 
-    size_t length = strlen(str);
-    custom_error_string = calloc(length + 1, sizeof(char));
-    strncpy(custom_error_string, str, length);
-    custom_error_string[length] = '\0';
+ttt_error_t error_get() {
+    return current.code;
 }
 
 bool error_is_set() {
-    return errno != TTT_ERROR_NONE;
+    return current.code != TTT_ERROR_NONE;
 }
 
 const char *error_get_string() {
-    if (!error_is_set()) {
+    return error_get_context_string(&current);
+}
+
+void error_reset() {
+    error_set(TTT_ERROR_NONE);
+}
+
+/// @brief Copies the error of the calling thread, e.g. to return it together with the result of a request
+void error_save(error_context_t *context) {
+    *context = current;
+}
+
+/// @return the message of the error or NULL if there is no error
+const char *error_get_context_string(const error_context_t *context) {
+    if (context->code == TTT_ERROR_NONE) {
         return NULL;
     }
 
-    if (custom_error_string) {
-        return custom_error_string;
+    if (context->string[0] != '\0') {
+        return context->string;
     }
 
-    ttt_error_t code = errno;
-
     // Default error code messages
-    switch (code) {
+    switch (context->code) {
     case TTT_ERROR_OUT_OF_MEMORY:
         return "ERROR: Out of memory";
 
@@ -54,11 +69,13 @@ const char *error_get_string() {
     case TTT_ERROR_HTML_PARSER_FAILED:
         return "ERROR: Could not parse HTML page content";
 
+    case TTT_ERROR_REQUEST_CANCELLED:
+        return "ERROR: HTTP request cancelled";
+
+    case TTT_ERROR_STORE_FAILED:
+        return "ERROR: Could not access stored pages";
+
     default:
         return "ERROR: Unknown";
     }
 }
-
-void error_reset() {
-    error_set(TTT_ERROR_NONE);
-}
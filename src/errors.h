@@ -1,10 +1,11 @@
 #pragma once
+#include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <stdbool.h>
-#include <errno.h>
 #include <string.h>
 
-extern int errno;
+#define ERROR_STRING_SIZE 128
 
 typedef enum ttt_error {
     TTT_ERROR_NONE,
@@ -12,11 +13,22 @@ typedef enum ttt_error {
     TTT_ERROR_REQUEST_FAILED,
     TTT_ERROR_PAGE_PARSER_FAILED,
     TTT_ERROR_HTML_PARSER_FAILED,
+    TTT_ERROR_REQUEST_CANCELLED,
+    TTT_ERROR_STORE_FAILED,
 } ttt_error_t;
 
+/// @brief The last error of a thread, or of a request when it is handed to another thread
+typedef struct error_context {
+    ttt_error_t code;
+    char string[ERROR_STRING_SIZE];     // empty for the default message of the code
+} error_context_t;
+
 bool error_is_set();
 void error_set(ttt_error_t code);
 void error_set_with_string(ttt_error_t code, const char *str);
+void error_set_with_format(ttt_error_t code, const char *format, ...);
 ttt_error_t error_get();
 const char *error_get_string();
 void error_reset();
+void error_save(error_context_t *context);
+const char *error_get_context_string(const error_context_t *context);
@@ -0,0 +1,230 @@
+#include "events.h"
+
+#define MAX_EVENT_SOURCES 16
+#define MAX_READY_EVENTS  8
+
+typedef enum event_source_type {
+    EVENT_SOURCE_NONE,
+    EVENT_SOURCE_FD,
+    EVENT_SOURCE_TIMER,
+    EVENT_SOURCE_SIGNAL
+} event_source_type_t;
+
+typedef struct event_source {
+    event_source_type_t type;
+    int fd;
+    int signal;
+    event_callback_t callback;
+    void *data;
+} event_source_t;
+
+static int epoll_fd = -1;
+static bool running = false;
+static event_source_t sources[MAX_EVENT_SOURCES];
+
+static int add_source(event_source_type_t type, int fd, event_callback_t callback, void *data) {
+    if (epoll_fd == -1 || fd < 0) {
+        return EVENTS_INVALID_SOURCE;
+    }
+
+    for (int i = 0; i < MAX_EVENT_SOURCES; i++) {
+        if (sources[i].type != EVENT_SOURCE_NONE) {
+            continue;
+        }
+
+        struct epoll_event event = {
+            .events = EPOLLIN,
+            .data.u32 = i
+        };
+
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            return EVENTS_INVALID_SOURCE;
+        }
+
+        sources[i].type = type;
+        sources[i].fd = fd;
+        sources[i].signal = 0;
+        sources[i].callback = callback;
+        sources[i].data = data;
+        return i;
+    }
+
+    return EVENTS_INVALID_SOURCE;
+}
+
+static bool is_valid_source(int source) {
+    return source >= 0 && source < MAX_EVENT_SOURCES && sources[source].type != EVENT_SOURCE_NONE;
+}
+
+/// @brief Consumes the event so that the fd is no longer readable
+static void acknowledge(event_source_t *source) {
+    uint64_t expirations;
+    struct signalfd_siginfo info;
+
+    switch (source->type) {
+    case EVENT_SOURCE_TIMER:
+        if (read(source->fd, &expirations, sizeof(expirations)) == -1) {
+            return;
+        }
+
+        break;
+
+    case EVENT_SOURCE_SIGNAL:
+        if (read(source->fd, &info, sizeof(info)) == -1) {
+            return;
+        }
+
+        break;
+
+    default:
+        // Regular fds are read by the callback
+        break;
+    }
+}
+
+bool events_initialize() {
+    if (epoll_fd != -1) {
+        return true;
+    }
+
+    memset(sources, 0, sizeof(sources));
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    return epoll_fd != -1;
+}
+
+/// @brief Calls the callback every time the fd becomes readable
+/// @return the event source or EVENTS_INVALID_SOURCE
+int events_add_fd(int fd, event_callback_t callback, void *data) {
+    return add_source(EVENT_SOURCE_FD, fd, callback, data);
+}
+
+/// @brief Creates a timer that is disarmed until 'events_set_timer()' is called
+/// @return the event source or EVENTS_INVALID_SOURCE
+int events_add_timer(event_callback_t callback, void *data) {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    int source = add_source(EVENT_SOURCE_TIMER, fd, callback, data);
+
+    if (source == EVENTS_INVALID_SOURCE && fd != -1) {
+        close(fd);
+    }
+
+    return source;
+}
+
+/// @brief Calls the callback when the signal is received. The signal is blocked
+///        for the whole process, so this must be called before any threads are created.
+/// @return the event source or EVENTS_INVALID_SOURCE
+int events_add_signal(int signal, event_callback_t callback, void *data) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, signal);
+
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1) {
+        return EVENTS_INVALID_SOURCE;
+    }
+
+    int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    int source = add_source(EVENT_SOURCE_SIGNAL, fd, callback, data);
+
+    if (source == EVENTS_INVALID_SOURCE) {
+        if (fd != -1) {
+            close(fd);
+        }
+
+        return source;
+    }
+
+    sources[source].signal = signal;
+    return source;
+}
+
+/// @brief Arms (or re-arms) a timer
+/// @param delay_ms the time until the first expiration, 0 disarms the timer
+/// @param interval_ms the time between each following expiration, 0 means only once
+void events_set_timer(int source, unsigned int delay_ms, unsigned int interval_ms) {
+    if (!is_valid_source(source) || sources[source].type != EVENT_SOURCE_TIMER) {
+        return;
+    }
+
+    struct itimerspec spec = {
+        .it_value = {
+            .tv_sec = delay_ms / 1000,
+            .tv_nsec = (delay_ms % 1000) * 1000000L
+        },
+        .it_interval = {
+            .tv_sec = interval_ms / 1000,
+            .tv_nsec = (interval_ms % 1000) * 1000000L
+        }
+    };
+
+    timerfd_settime(sources[source].fd, 0, &spec, NULL);
+}
+
+void events_remove(int source) {
+    if (!is_valid_source(source)) {
+        return;
+    }
+
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, sources[source].fd, NULL);
+
+    if (sources[source].type == EVENT_SOURCE_SIGNAL) {
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigaddset(&mask, sources[source].signal);
+        sigprocmask(SIG_UNBLOCK, &mask, NULL);
+    }
+
+    // Fds added with 'events_add_fd()' are owned by the caller
+    if (sources[source].type != EVENT_SOURCE_FD) {
+        close(sources[source].fd);
+    }
+
+    sources[source].type = EVENT_SOURCE_NONE;
+}
+
+/// @brief Waits for events and calls their callbacks until 'events_stop()' is called.
+///        The process sleeps while waiting, i.e. no CPU time is used when idle.
+void events_run() {
+    struct epoll_event ready[MAX_READY_EVENTS];
+    running = epoll_fd != -1;
+
+    while (running) {
+        int count = epoll_wait(epoll_fd, ready, MAX_READY_EVENTS, -1);
+
+        if (count == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            break;
+        }
+
+        for (int i = 0; i < count && running; i++) {
+            int index = ready[i].data.u32;
+
+            // The source might have been removed by a previous callback
+            if (!is_valid_source(index)) {
+                continue;
+            }
+
+            event_source_t *source = &sources[index];
+            acknowledge(source);
+            source->callback(source->data);
+        }
+    }
+}
+
+void events_stop() {
+    running = false;
+}
+
+void events_destroy() {
+    for (int i = 0; i < MAX_EVENT_SOURCES; i++) {
+        events_remove(i);
+    }
+
+    if (epoll_fd != -1) {
+        close(epoll_fd);
+        epoll_fd = -1;
+    }
+}
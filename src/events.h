@@ -0,0 +1,26 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
+
+#define EVENTS_INVALID_SOURCE -1
+
+typedef void (*event_callback_t)(void *data);
+
+bool events_initialize();
+int events_add_fd(int fd, event_callback_t callback, void *data);
+int events_add_timer(event_callback_t callback, void *data);
+int events_add_signal(int signal, event_callback_t callback, void *data);
+void events_set_timer(int source, unsigned int delay_ms, unsigned int interval_ms);
+void events_remove(int source);
+void events_run();
+void events_stop();
+void events_destroy();
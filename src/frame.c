@@ -0,0 +1,152 @@
+#include "frame.h"
+
+// Rendered pages, identified by their serial since
+// the memory of a destroyed page might be reused.
+typedef struct frame_cache_entry {
+    uint32_t serial;
+    uint64_t last_used;
+    frame_t frame;
+} frame_cache_entry_t;
+
+static frame_cache_entry_t frame_cache[FRAME_CACHE_SIZE];
+static uint64_t frame_cache_clock = 0;
+
+/// @brief Returns the cached frame of a page
+/// @return the frame or NULL if the page has not been rendered
+frame_t *frame_cache_get(page_t *page) {
+    if (!page || page->serial == 0) {
+        return NULL;
+    }
+
+    for (int i = 0; i < FRAME_CACHE_SIZE; i++) {
+        if (frame_cache[i].serial == page->serial) {
+            frame_cache[i].last_used = ++frame_cache_clock;
+            return &frame_cache[i].frame;
+        }
+    }
+
+    return NULL;
+}
+
+/// @brief Reserves a frame for the page, replacing the least recently used one
+/// @return the frame that the page should be rendered into or NULL if the page can not be cached
+frame_t *frame_cache_put(page_t *page) {
+    if (!page || page->serial == 0) {
+        return NULL;
+    }
+
+    frame_cache_entry_t *entry = &frame_cache[0];
+
+    for (int i = 0; i < FRAME_CACHE_SIZE; i++) {
+        if (frame_cache[i].serial == page->serial) {
+            entry = &frame_cache[i];
+            break;
+        }
+
+        if (frame_cache[i].last_used < entry->last_used) {
+            entry = &frame_cache[i];
+        }
+    }
+
+    entry->serial = page->serial;
+    entry->last_used = ++frame_cache_clock;
+    return &entry->frame;
+}
+
+void frame_clear(frame_t *frame, attr_t attr) {
+    chtype empty = ' ' | attr;
+    chtype *cells = &frame->cells[0][0];
+
+    for (int i = 0; i < PAGE_LINES * PAGE_COLS; i++) {
+        cells[i] = empty;
+    }
+}
+
+/// @brief Prints a string to the frame, wrapping at the end of each line
+void frame_print(frame_t *frame, int line, int col, const char *str, attr_t attr) {
+    assert(line >= 0 && line < PAGE_LINES);
+    assert(col >= 0 && col < PAGE_COLS);
+    chtype *cells = &frame->cells[0][0];
+    int position = line * PAGE_COLS + col;
+
+    for (; *str != '\0' && position < PAGE_LINES * PAGE_COLS; str++, position++) {
+        cells[position] = (unsigned char)(*str) | attr;
+    }
+}
+
+/// @brief Replaces the attributes of length cells, wrapping at the end of each line
+void frame_set_attr(frame_t *frame, int line, int col, size_t length, attr_t attr) {
+    assert(line >= 0 && line < PAGE_LINES);
+    assert(col >= 0 && col < PAGE_COLS);
+    chtype *cells = &frame->cells[0][0];
+    size_t position = line * PAGE_COLS + col;
+
+    for (size_t i = 0; i < length && position < PAGE_LINES * PAGE_COLS; i++, position++) {
+        cells[position] = (cells[position] & A_CHARTEXT) | attr;
+    }
+}
+
+void frame_from_grid_row(frame_t *frame, page_grid_t *grid, int line) {
+    for (int col = 0; col < PAGE_COLS; col++) {
+        page_grid_cell_t *cell = &grid->cells[line][col];
+        attr_t attr = cell->token ? cell->token->attr : COLOR_PAIR(COLORSCHEME_DEFAULT);
+        frame->cells[line][col] = (unsigned char)cell->glyph | attr;
+    }
+}
+
+void frame_from_grid(frame_t *frame, page_grid_t *grid) {
+    for (int line = 0; line < PAGE_LINES; line++) {
+        frame_from_grid_row(frame, grid, line);
+    }
+}
+
+/// @brief Reads the contents of a (usually off-screen) window into the frame
+void frame_from_window(frame_t *frame, WINDOW *win) {
+    chtype buf[PAGE_COLS + 1];
+
+    for (int line = 0; line < PAGE_LINES; line++) {
+        mvwinchnstr(win, line, 0, buf, PAGE_COLS);
+        memcpy(frame->cells[line], buf, sizeof(frame->cells[line]));
+    }
+}
+
+/// @brief Writes the cells that differ between the shown and the next frame
+///        to the window, and marks the window for the next 'doupdate()'.
+/// @param shown the frame that is currently visible, updated to match next
+/// @param force write every cell, e.g. if the window contents have been lost
+/// @return the number of cells that were written
+int frame_present(WINDOW *win, frame_t *shown, frame_t *next, bool force) {
+    int written = 0;
+
+    for (int line = 0; line < PAGE_LINES; line++) {
+        int first = 0;
+        int last = PAGE_COLS - 1;
+
+        if (!force) {
+            while (first < PAGE_COLS && shown->cells[line][first] == next->cells[line][first]) {
+                first++;
+            }
+
+            if (first == PAGE_COLS) {
+                continue;
+            }
+
+            while (shown->cells[line][last] == next->cells[line][last]) {
+                last--;
+            }
+        }
+
+        // Unlike 'waddch()', this does not move the cursor or wrap,
+        // which means that we can also write the bottom right cell.
+        mvwaddchnstr(win, line, first, &next->cells[line][first], last - first + 1);
+        memcpy(&shown->cells[line][first], &next->cells[line][first], (last - first + 1) * sizeof(chtype));
+        written += last - first + 1;
+    }
+
+    if (force) {
+        touchwin(win);
+    }
+
+    wnoutrefresh(win);
+    return written;
+}
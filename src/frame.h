@@ -0,0 +1,30 @@
+#pragma once
+#include <curses.h>
+#include <string.h>
+#include <assert.h>
+
+#include "grid.h"
+#include "pages.h"
+#include "colors.h"
+#include "shared.h"
+
+#define FRAME_CACHE_SIZE 16
+
+typedef struct frame frame_t;
+
+// A fully rendered page, i.e. the exact characters and attributes
+// that should be visible in the page window.
+struct frame {
+    chtype cells[PAGE_LINES][PAGE_COLS];
+};
+
+frame_t *frame_cache_get(page_t *page);
+frame_t *frame_cache_put(page_t *page);
+
+void frame_clear(frame_t *frame, attr_t attr);
+void frame_print(frame_t *frame, int line, int col, const char *str, attr_t attr);
+void frame_set_attr(frame_t *frame, int line, int col, size_t length, attr_t attr);
+void frame_from_grid_row(frame_t *frame, page_grid_t *grid, int line);
+void frame_from_grid(frame_t *frame, page_grid_t *grid);
+void frame_from_window(frame_t *frame, WINDOW *win);
+int frame_present(WINDOW *win, frame_t *shown, frame_t *next, bool force);
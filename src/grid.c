@@ -0,0 +1,289 @@
+#include "grid.h"
+
+#define FNV_OFFSET_BASIS      2166136261u
+#define FNV_PRIME             16777619u
+#define INITIAL_LINK_CAPACITY 8
+
+static uint32_t hash_byte(uint32_t hash, uint8_t byte) {
+    return (hash ^ byte) * FNV_PRIME;
+}
+
+static uint32_t hash_cell(uint32_t hash, page_grid_cell_t *cell) {
+    hash = hash_byte(hash, cell->glyph);
+
+    if (!cell->token) {
+        return hash_byte(hash, 0xff);
+    }
+
+    hash = hash_byte(hash, cell->token->type);
+    hash = hash_byte(hash, cell->token->style.fg);
+    hash = hash_byte(hash, cell->token->style.bg);
+    return hash_byte(hash, cell->token->style.extra);
+}
+
+static void hash_rows(page_grid_t *grid) {
+    for (int line = 0; line < PAGE_LINES; line++) {
+        uint32_t hash = FNV_OFFSET_BASIS;
+
+        for (int col = 0; col < PAGE_COLS; col++) {
+            hash = hash_cell(hash, &grid->cells[line][col]);
+        }
+
+        grid->row_hashes[line] = hash;
+    }
+}
+
+static bool add_link(page_grid_t *grid, page_token_t *token, size_t position) {
+    if (grid->link_count == grid->link_capacity) {
+        size_t capacity = grid->link_capacity ? grid->link_capacity * 2 : INITIAL_LINK_CAPACITY;
+        page_link_t *links = realloc(grid->links, sizeof(page_link_t) * capacity);
+
+        if (!links) {
+            error_set(TTT_ERROR_OUT_OF_MEMORY);
+            return false;
+        }
+
+        grid->links = links;
+        grid->link_capacity = capacity;
+    }
+
+    page_link_t *link = &grid->links[grid->link_count];
+    link->href = token->href;
+    link->line = position / PAGE_COLS;
+    link->col = position % PAGE_COLS;
+    link->length = 0;
+    link->token = token;
+    grid->link_count++;
+    return true;
+}
+
+/// @brief Returns the horizontal distance between two links, 0 if they overlap
+static int horizontal_distance(page_link_t *a, page_link_t *b) {
+    int a_end = a->col + (int)a->length - 1;
+    int b_end = b->col + (int)b->length - 1;
+
+    if (a_end < b->col) {
+        return b->col - a_end;
+    } else if (b_end < a->col) {
+        return a->col - b_end;
+    }
+
+    return 0;
+}
+
+/// @brief Finds the closest link on the closest line above (step = -1) or below (step = 1)
+static int find_vertical_neighbour(page_grid_t *grid, int index, int step) {
+    page_link_t *link = &grid->links[index];
+    int best = GRID_NO_LINK;
+    int best_distance = INT_MAX;
+
+    // The links are sorted by position, so the closest lines are found first
+    for (int i = index + step; i >= 0 && i < (int)grid->link_count; i += step) {
+        page_link_t *other = &grid->links[i];
+
+        if (other->line == link->line) {
+            continue;
+        } else if (best != GRID_NO_LINK && other->line != grid->links[best].line) {
+            break;
+        }
+
+        int distance = horizontal_distance(link, other);
+
+        if (distance < best_distance) {
+            best = i;
+            best_distance = distance;
+        }
+    }
+
+    return best;
+}
+
+/// @brief Finds the closest link on the same line to the left (step = -1) or right (step = 1)
+static int find_horizontal_neighbour(page_grid_t *grid, int index, int step) {
+    int i = index + step;
+
+    // The links are sorted by position, so the closest link on the line is next to it
+    if (i < 0 || i >= (int)grid->link_count || grid->links[i].line != grid->links[index].line) {
+        return GRID_NO_LINK;
+    }
+
+    return i;
+}
+
+/// @brief Precomputes the closest link in every direction, so that
+///        moving between links never has to search the page
+static void link_neighbours(page_grid_t *grid) {
+    for (int i = 0; i < (int)grid->link_count; i++) {
+        page_link_t *link = &grid->links[i];
+        link->neighbours[LINK_DIRECTION_UP] = find_vertical_neighbour(grid, i, -1);
+        link->neighbours[LINK_DIRECTION_DOWN] = find_vertical_neighbour(grid, i, 1);
+        link->neighbours[LINK_DIRECTION_LEFT] = find_horizontal_neighbour(grid, i, -1);
+        link->neighbours[LINK_DIRECTION_RIGHT] = find_horizontal_neighbour(grid, i, 1);
+    }
+}
+
+/// @brief Checks if two cells would be displayed in the same way
+static bool cells_equal(page_grid_cell_t *a, page_grid_cell_t *b) {
+    if (a->glyph != b->glyph) {
+        return false;
+    }
+
+    if (!a->token || !b->token) {
+        return a->token == b->token;
+    }
+
+    return a->token->type == b->token->type &&
+           a->token->style.fg == b->token->style.fg &&
+           a->token->style.bg == b->token->style.bg &&
+           a->token->style.extra == b->token->style.extra;
+}
+
+/// @brief Lays out the page tokens in the same way as they would be printed to
+///        a PAGE_LINES x PAGE_COLS window, i.e. wrapping at the end of each line
+///        and discarding anything that does not fit on the page.
+page_grid_t *grid_create(page_t *page) {
+    page_grid_t *grid = calloc(1, sizeof(page_grid_t));
+
+    if (!grid) {
+        return NULL;
+    }
+
+    page_grid_cell_t *cells = &grid->cells[0][0];
+    size_t position = 0;
+
+    for (size_t i = 0; i < PAGE_LINES * PAGE_COLS; i++) {
+        cells[i].glyph = GRID_CELL_EMPTY_GLYPH;
+        cells[i].link = GRID_NO_LINK;
+    }
+
+    page_token_t *cursor = page_get_tokens(page);
+
+    while (cursor && position < PAGE_LINES * PAGE_COLS) {
+        int link = GRID_NO_LINK;
+
+        if (cursor->type == PAGE_TOKEN_LINK && cursor->length > 0) {
+            if (!add_link(grid, cursor, position)) {
+                grid_destroy(grid);
+                return NULL;
+            }
+
+            link = grid->link_count - 1;
+        }
+
+        for (size_t i = 0; i < cursor->length && position < PAGE_LINES * PAGE_COLS; i++) {
+            cells[position].glyph = cursor->text[i];
+            cells[position].token = cursor;
+            cells[position].link = link;
+            position++;
+
+            if (link != GRID_NO_LINK) {
+                grid->links[link].length++;
+            }
+        }
+
+        cursor = cursor->next;
+    }
+
+    hash_rows(grid);
+    link_neighbours(grid);
+    return grid;
+}
+
+/// @brief Returns the grid of the page, laying out the page on first use
+/// @return the grid or NULL if the page could not be laid out
+page_grid_t *grid_get(page_t *page) {
+    if (!page) {
+        return NULL;
+    }
+
+    if (!page->grid) {
+        page->grid = grid_create(page);
+    }
+
+    return page->grid;
+}
+
+page_grid_cell_t *grid_get_cell(page_grid_t *grid, int line, int col) {
+    if (!grid || line < 0 || line >= PAGE_LINES || col < 0 || col >= PAGE_COLS) {
+        return NULL;
+    }
+
+    return &grid->cells[line][col];
+}
+
+uint32_t grid_get_row_hash(page_grid_t *grid, int line) {
+    assert(line >= 0 && line < PAGE_LINES);
+    return grid->row_hashes[line];
+}
+
+bool grid_rows_equal(page_grid_t *grid, int line, page_grid_t *other, int other_line) {
+    if (grid->row_hashes[line] != other->row_hashes[other_line]) {
+        return false;
+    }
+
+    // Rule out hash collisions
+    for (int col = 0; col < PAGE_COLS; col++) {
+        if (!cells_equal(&grid->cells[line][col], &other->cells[other_line][col])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+page_link_t *grid_get_link(page_grid_t *grid, int index) {
+    if (!grid || index < 0 || index >= (int)grid->link_count) {
+        return NULL;
+    }
+
+    return &grid->links[index];
+}
+
+/// @return the index of the link at the position or GRID_NO_LINK
+int grid_get_link_at(page_grid_t *grid, int line, int col) {
+    page_grid_cell_t *cell = grid_get_cell(grid, line, col);
+    return cell ? cell->link : GRID_NO_LINK;
+}
+
+/// @return the index of the closest link in the direction or GRID_NO_LINK
+int grid_get_link_neighbour(page_grid_t *grid, int index, link_direction_t direction) {
+    page_link_t *link = grid_get_link(grid, index);
+
+    if (!link || direction < 0 || direction >= LINK_DIRECTION_COUNT) {
+        return GRID_NO_LINK;
+    }
+
+    return link->neighbours[direction];
+}
+
+/// @brief Copies the glyphs of a row into a null-terminated buffer
+/// @param buf_size the size of buf, should be at least PAGE_COLS + 1
+void grid_get_row_text(page_grid_t *grid, int line, char *buf, size_t buf_size) {
+    assert(buf != NULL);
+    assert(buf_size != 0);
+    size_t length = buf_size - 1 < PAGE_COLS ? buf_size - 1 : PAGE_COLS;
+
+    for (size_t col = 0; col < length; col++) {
+        buf[col] = grid->cells[line][col].glyph;
+    }
+
+    buf[length] = '\0';
+}
+
+void grid_destroy(page_grid_t *grid) {
+    if (!grid) {
+        return;
+    }
+
+    free(grid->links);
+    free(grid);
+}
+
+void grid_print(page_grid_t *grid) {
+    char buf[PAGE_COLS + 1];
+
+    for (int line = 0; line < PAGE_LINES; line++) {
+        grid_get_row_text(grid, line, buf, sizeof(buf));
+        printf("%2d |%s| %08x\n", line, buf, grid->row_hashes[line]);
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <limits.h>
+
+#include "pages.h"
+#include "shared.h"
+#include "errors.h"
+
+#define GRID_CELL_EMPTY_GLYPH ' '
+#define GRID_NO_LINK          -1
+
+typedef struct page_grid_cell page_grid_cell_t;
+typedef struct page_link page_link_t;
+
+typedef enum link_direction {
+    LINK_DIRECTION_UP,
+    LINK_DIRECTION_DOWN,
+    LINK_DIRECTION_LEFT,
+    LINK_DIRECTION_RIGHT,
+    LINK_DIRECTION_COUNT
+} link_direction_t;
+
+// A single character on a laid out page.
+// Cells that are not covered by any token (i.e. the background) have no token.
+struct page_grid_cell {
+    char glyph;
+    int link;                   // index in the link table or GRID_NO_LINK
+    page_token_t *token;
+};
+
+// A link and its position on the page. The link text might wrap
+// to the next line, which means that col + length can be larger than PAGE_COLS.
+struct page_link {
+    uint16_t href;
+    int line, col;
+    size_t length;
+    page_token_t *token;
+    int neighbours[LINK_DIRECTION_COUNT];   // closest link in each direction or GRID_NO_LINK
+};
+
+// The page as it is displayed, a fixed PAGE_LINES x PAGE_COLS grid of cells.
+// Each row has a hash of its glyphs and styles so that rows can be compared
+// without comparing every cell.
+struct page_grid {
+    page_grid_cell_t cells[PAGE_LINES][PAGE_COLS];
+    uint32_t row_hashes[PAGE_LINES];
+    page_link_t *links;         // in the order that they appear on the page
+    size_t link_count;
+    size_t link_capacity;
+};
+
+page_grid_t *grid_create(page_t *page);
+page_grid_t *grid_get(page_t *page);
+page_grid_cell_t *grid_get_cell(page_grid_t *grid, int line, int col);
+uint32_t grid_get_row_hash(page_grid_t *grid, int line);
+bool grid_rows_equal(page_grid_t *grid, int line, page_grid_t *other, int other_line);
+page_link_t *grid_get_link(page_grid_t *grid, int index);
+int grid_get_link_at(page_grid_t *grid, int line, int col);
+int grid_get_link_neighbour(page_grid_t *grid, int index, link_direction_t direction);
+void grid_get_row_text(page_grid_t *grid, int line, char *buf, size_t buf_size);
+void grid_destroy(page_grid_t *grid);
+void grid_print(page_grid_t *grid);
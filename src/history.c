@@ -0,0 +1,151 @@
+#include "history.h"
+
+// The pages that have been visited, oldest first. Every page in the history
+// is pinned in the cache, so going back or forward never has to fetch,
+// parse or render a page again.
+struct history {
+    page_cache_t *cache;
+    history_entry_t *entries;
+    size_t count;
+    size_t capacity;
+    size_t position;            // the entry of the page that is shown
+};
+
+static void clear_entry(history_t *history, history_entry_t *entry) {
+    cache_unpin(history->cache, entry->page);
+    free(entry->frame);
+    entry->page = NULL;
+    entry->frame = NULL;
+}
+
+/// @brief Creates a history that remembers at most 'capacity' pages
+history_t *history_create(page_cache_t *cache, size_t capacity) {
+    history_t *history = calloc(1, sizeof(history_t));
+
+    if (!history) {
+        error_set(TTT_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    history->entries = calloc(capacity ? capacity : 1, sizeof(history_entry_t));
+
+    if (!history->entries) {
+        free(history);
+        error_set(TTT_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    history->cache = cache;
+    history->capacity = capacity ? capacity : 1;
+    return history;
+}
+
+/// @brief Adds a page after the current one and makes it current. The pages that
+///        could be reached with 'history_forward()' are forgotten, and so is the
+///        oldest page if the history is full.
+bool history_push(history_t *history, page_t *page) {
+    if (!history || !page) {
+        return false;
+    }
+
+    // Pin the new page first, it might be one of the pages that are about to be forgotten
+    cache_pin(history->cache, page);
+
+    for (size_t i = history->count > 0 ? history->position + 1 : 0; i < history->count; i++) {
+        clear_entry(history, &history->entries[i]);
+    }
+
+    history->count = history->count > 0 ? history->position + 1 : 0;
+
+    if (history->count == history->capacity) {
+        clear_entry(history, &history->entries[0]);
+        history->count--;
+        memmove(history->entries, history->entries + 1, history->count * sizeof(history_entry_t));
+    }
+
+    history->entries[history->count] = (history_entry_t) {
+        .page = page,
+        .link_index = -1,
+        .frame = NULL
+    };
+    history->position = history->count;
+    history->count++;
+    return true;
+}
+
+/// @return the entry of the page that is shown or NULL if the history is empty
+history_entry_t *history_get_current(history_t *history) {
+    if (!history || history->count == 0) {
+        return NULL;
+    }
+
+    return &history->entries[history->position];
+}
+
+/// @return the previous entry, which becomes current, or NULL if there is none
+history_entry_t *history_back(history_t *history) {
+    if (!history || history->count == 0 || history->position == 0) {
+        return NULL;
+    }
+
+    history->position--;
+    return &history->entries[history->position];
+}
+
+/// @return the next entry, which becomes current, or NULL if there is none
+history_entry_t *history_forward(history_t *history) {
+    if (!history || history->position + 1 >= history->count) {
+        return NULL;
+    }
+
+    history->position++;
+    return &history->entries[history->position];
+}
+
+/// @brief Replaces the current page with a newer version of it, e.g. after it has been updated
+void history_replace_current(history_t *history, page_t *page) {
+    history_entry_t *entry = history_get_current(history);
+
+    if (!entry || !page || entry->page == page) {
+        return;
+    }
+
+    cache_pin(history->cache, page);
+    cache_unpin(history->cache, entry->page);
+    entry->page = page;
+}
+
+/// @brief Remembers how the current page looked when it was left,
+///        the history takes ownership of the frame
+void history_set_state(history_t *history, int link_index, struct frame *frame) {
+    history_entry_t *entry = history_get_current(history);
+
+    if (!entry) {
+        free(frame);
+        return;
+    }
+
+    if (entry->frame != frame) {
+        free(entry->frame);
+    }
+
+    entry->link_index = link_index;
+    entry->frame = frame;
+}
+
+size_t history_get_size(history_t *history) {
+    return history ? history->count : 0;
+}
+
+void history_destroy(history_t *history) {
+    if (!history) {
+        return;
+    }
+
+    for (size_t i = 0; i < history->count; i++) {
+        clear_entry(history, &history->entries[i]);
+    }
+
+    free(history->entries);
+    free(history);
+}
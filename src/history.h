@@ -0,0 +1,31 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "pages.h"
+#include "cache.h"
+#include "errors.h"
+
+struct frame;
+
+typedef struct history_entry {
+    page_t *page;
+    int link_index;             // the highlighted link when the page was left, -1 if none
+    struct frame *frame;        // the rendered page when it was left, owned by the history
+} history_entry_t;
+
+typedef struct history history_t;
+
+history_t *history_create(page_cache_t *cache, size_t capacity);
+bool history_push(history_t *history, page_t *page);
+history_entry_t *history_get_current(history_t *history);
+history_entry_t *history_back(history_t *history);
+history_entry_t *history_forward(history_t *history);
+void history_replace_current(history_t *history, page_t *page);
+void history_set_state(history_t *history, int link_index, struct frame *frame);
+size_t history_get_size(history_t *history);
+void history_destroy(history_t *history);
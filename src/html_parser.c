@@ -88,11 +88,10 @@ static void replace_unicode_escape_sequence(const char *html_content, int *start
     } else if (strncmp(sequence_start, "\\u00e9", UNICODE_ESCAPE_SEQUENCE_LENGTH) == 0) {
         (*dest)[*dest_position] = 'e';
     } else {
-        char error[256];
-        snprintf(error, 256, "ERROR: Found unhandled unicode escape sequence: %.6s", sequence_start);
-        error_set_with_string(
+        error_set_with_format(
             TTT_ERROR_HTML_PARSER_FAILED,
-            error
+            "ERROR: Found unhandled unicode escape sequence: %.6s",
+            sequence_start
         );
         // There is no need to die if we found an unhandled escape sequence,
         // but we should make sure to show an error so that it can be fixed
@@ -125,11 +124,10 @@ static void replace_html_escape_sequence(const char *html_content, int *start_in
     } else if (strcmp(buf, "&gt;") == 0) {
         (*dest)[*dest_position] = '>';
     } else {
-        char error[256];
-        snprintf(error, 256, "ERROR: Found unhandled html escape sequence: %s", buf);
-        error_set_with_string(
+        error_set_with_format(
             TTT_ERROR_HTML_PARSER_FAILED,
-            error
+            "ERROR: Found unhandled html escape sequence: %s",
+            buf
         );
         (*dest)[*dest_position] = 'X';
     }
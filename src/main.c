@@ -1,5 +1,9 @@
 #include "ui.h"
 #include <unistd.h>
+#include <poll.h>
+
+// One worker is always left for the pages that are shown, see 'scheduler_take()'
+#define CRAWL_WORKER_COUNT 2
 
 void print_help() {
     printf("usage ttt [-h] [-r]\n\n");
@@ -10,12 +14,92 @@ void print_help() {
     printf("-r          restore terminal colors on quit\n");
     printf("-d          do not overwrite terminal colors (might decrease readability)\n");
     printf("-t          transparent background for page content (works well with '-d')\n");
+    printf("-a          write pages directly to the terminal instead of through ncurses\n");
+    printf("-l          low bandwidth mode, minimize the bytes written to the terminal (implies '-a')\n");
+    printf("-c          store every page for offline use and exit\n");
+    printf("--timing    print how long it took to show the first page on quit\n\n");
+    printf("environment variables:\n");
+    printf("TTT_TRACE   write a trace of the requests, parsing and drawing to a file,\n");
+    printf("            which can be opened in chrome://tracing or Perfetto\n");
+}
+
+bool start_trace() {
+    if (!trace_initialize()) {
+        printf("Failed to open the trace file '%s'\n", getenv(TRACE_ENV_VARIABLE));
+        return false;
+    }
+
+    return true;
+}
+
+void print_crawl_progress(crawler_progress_t *progress, void *data) {
+    *(crawler_progress_t *)data = *progress;
+
+    if (progress->finished) {
+        // The error is only set during the last call
+        if (error_is_set()) {
+            printf("\n%s\n", error_get_string());
+        }
+
+        return;
+    }
+
+    printf(
+        "\rCrawling pages: %3d%% (%zu pages), %" PRIu64 " s left  ",
+        progress->done * 100 / progress->total,
+        progress->pages,
+        (progress->remaining_ms + 999) / 1000
+    );
+    fflush(stdout);
+}
+
+/// @brief Crawls with the same workers and scheduler as the UI, so that the crawl
+///        is rate limited in the same way
+/// @return the exit code, which is not 0 if any pages could not be stored
+int crawl() {
+    page_store_t *store = store_open(NULL);
+    crawler_progress_t progress = {0};
+
+    if (!workers_initialize(CRAWL_WORKER_COUNT) || !crawler_start(store, NULL, print_crawl_progress, &progress)) {
+        printf("%s\n", error_is_set() ? error_get_string() : "Failed to start the workers");
+        workers_destroy();
+        store_close(store);
+        return 1;
+    }
+
+    while (crawler_is_running()) {
+        struct pollfd completed = {.fd = workers_get_fd(), .events = POLLIN};
+        poll(&completed, 1, -1);
+        workers_handle_completed();
+    }
+
+    workers_destroy();
+
+    // The error has been printed, see 'print_crawl_progress()'
+    if (progress.done < progress.total || progress.pages == 0) {
+        store_close(store);
+        return 1;
+    }
+
+    printf("\nStored %zu pages in %.1f s", progress.pages, progress.elapsed_ms / 1000.0);
+
+    if (progress.failed_ranges > 0) {
+        printf(", %zu ranges of pages could not be fetched", progress.failed_ranges);
+    }
+
+    printf("\n");
+    store_close(store);
+    return progress.failed_ranges > 0 ? 1 : 0;
 }
 
 int main(int argc, char *argv[]) {
     bool reset = false;
     bool overwrite_colors = true;
     bool transparent_background = false;
+    draw_backend_t backend = DRAW_BACKEND_CURSES;
+    bool low_bandwidth = false;
+    bool timing = false;
+    bool crawl_pages = false;
 
     if (argc > 1) {
         for (int i = 1; i < argc; i++) {
@@ -26,6 +110,15 @@ int main(int argc, char *argv[]) {
                 overwrite_colors = false;
             } else if (strcmp(argv[i], "-t") == 0) {
                 transparent_background = true;
+            } else if (strcmp(argv[i], "-a") == 0) {
+                backend = DRAW_BACKEND_ANSI;
+            } else if (strcmp(argv[i], "-l") == 0) {
+                backend = DRAW_BACKEND_ANSI;
+                low_bandwidth = true;
+            } else if (strcmp(argv[i], "-c") == 0) {
+                crawl_pages = true;
+            } else if (strcmp(argv[i], "--timing") == 0) {
+                timing = true;
             } else {
                 print_help();
                 return 1;
@@ -33,9 +126,28 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    ui_initialize(overwrite_colors, transparent_background);
+    if (!start_trace()) {
+        return 1;
+    }
+
+    api_initialize();
+
+    if (crawl_pages) {
+        int result = crawl();
+        api_destroy();
+        trace_destroy();
+        return result;
+    }
+
+    ui_initialize(overwrite_colors, transparent_background, backend, low_bandwidth);
     ui_event_loop();
     ui_destroy();
+    api_destroy();
+    trace_destroy();
+
+    if (timing) {
+        ui_print_startup_timing();
+    }
 
     if (reset) {
         // Seems like this is one of the only ways to actually restore the terminal colors
@@ -0,0 +1,94 @@
+#include "output.h"
+
+#define IO_STATS_PATH     "/proc/thread-self/io"
+#define IO_STATS_BUF_SIZE 256
+#define IO_STATS_WRITTEN  "wchar: "
+
+// Curses writes straight to the terminal, so the bytes that it writes are read from
+// the I/O statistics of the thread that draws, i.e. the main thread. The statistics
+// are only read for the curses backend, since the ANSI backend writes everything
+// through 'output_write()' and should not make any more syscalls than it has to.
+static int io_stats_fd = -1;
+static uint64_t initial_bytes_written = 0;
+static uint64_t initial_trace_bytes_written = 0;
+static uint64_t bytes_written = 0;
+
+static bool read_bytes_written(uint64_t *bytes) {
+    char buf[IO_STATS_BUF_SIZE];
+    ssize_t size = pread(io_stats_fd, buf, IO_STATS_BUF_SIZE - 1, 0);
+
+    if (size <= 0) {
+        return false;
+    }
+
+    buf[size] = '\0';
+    char *written = strstr(buf, IO_STATS_WRITTEN);
+
+    if (!written) {
+        return false;
+    }
+
+    *bytes = strtoull(written + strlen(IO_STATS_WRITTEN), NULL, 10);
+    return true;
+}
+
+/// @brief Starts counting the bytes written to the terminal, must be called
+///        from the thread that writes to the terminal before anything is written
+/// @param count_all_writes whether to count the writes of curses as well, and not
+///        only those through 'output_write()'
+void output_initialize(bool count_all_writes) {
+    if (!count_all_writes) {
+        return;
+    }
+
+    io_stats_fd = open(IO_STATS_PATH, O_RDONLY | O_CLOEXEC);
+    initial_trace_bytes_written = trace_get_thread_bytes_written();
+
+    if (io_stats_fd != -1 && !read_bytes_written(&initial_bytes_written)) {
+        close(io_stats_fd);
+        io_stats_fd = -1;
+    }
+}
+
+void output_destroy() {
+    if (io_stats_fd != -1) {
+        close(io_stats_fd);
+        io_stats_fd = -1;
+    }
+}
+
+/// @brief Writes everything to the terminal with as few syscalls as possible
+bool output_write(const char *data, size_t size) {
+    size_t written = 0;
+
+    while (written < size) {
+        ssize_t result = write(STDOUT_FILENO, data + written, size - written);
+
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return false;
+        }
+
+        written += result;
+    }
+
+    bytes_written += written;
+    return true;
+}
+
+/// @brief Returns the number of bytes written to the terminal, by curses or directly.
+///        Only counts the bytes from 'output_write()' if the I/O statistics are not used.
+uint64_t output_get_bytes_written() {
+    uint64_t bytes;
+
+    if (io_stats_fd == -1 || !read_bytes_written(&bytes)) {
+        return bytes_written;
+    }
+
+    // The trace is written by the thread that happens to fill its buffer
+    uint64_t trace_bytes = trace_get_thread_bytes_written() - initial_trace_bytes_written;
+    return bytes - initial_bytes_written - trace_bytes;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#include "trace.h"
+
+void output_initialize(bool count_all_writes);
+void output_destroy();
+bool output_write(const char *data, size_t size);
+uint64_t output_get_bytes_written();
@@ -1,13 +1,23 @@
 #include "pages.h"
+#include "grid.h"
+#include "html_parser.h"
+#include "trace.h"
+#include <stdatomic.h>
 
+// Pages are created by the worker threads as well
+static _Atomic uint32_t next_page_serial = 1;
 static page_t empty_page = {
+    .serial = 0,
     .id = -1,
     .prev_id = -1,
     .next_id = -1,
     .unix_date = -1,
     .title = NULL,
+    .content = NULL,
+    .content_length = 0,
     .tokens = NULL,
-    .last_token = NULL
+    .last_token = NULL,
+    .grid = NULL
 };
 
 page_t *page_create_empty() {
@@ -18,6 +28,7 @@ page_t *page_create_empty() {
     }
 
     memcpy(page, &empty_page, sizeof(empty_page));
+    page->serial = atomic_fetch_add(&next_page_serial, 1);
     return page;
 }
 
@@ -78,6 +89,51 @@ void page_collection_resize(page_collection_t *collection, size_t new_size) {
     collection->size = new_size;
 }
 
+/// @brief Parses the HTML content of a page the first time that its tokens are needed,
+///        so that pages that are only prefetched or fetched in ranges are never parsed.
+///        Content that can not be parsed is kept, so that the error is set every time.
+/// @return the first token or NULL if the page has no tokens
+page_token_t *page_get_tokens(page_t *page) {
+    if (!page) {
+        return NULL;
+    }
+
+    if (page->content) {
+        trace_begin("tokenize", page->id);
+        html_parser_get_page_tokens(page, page->content, page->content_length);
+        trace_end("tokenize", page->id);
+
+        if (page->tokens) {
+            free(page->content);
+            page->content = NULL;
+            page->content_length = 0;
+        }
+    }
+
+    return page->tokens;
+}
+
+/// @brief Checks if the tokens of a page can be used without parsing it
+bool page_is_tokenized(page_t *page) {
+    return page && !page->content;
+}
+
+/// @brief Gives a page the tokens that were parsed from a copy of its content
+///        on another thread, if it has not been parsed since
+void page_move_tokens(page_t *page, page_t *parsed) {
+    if (!page->content || !parsed->tokens) {
+        return;
+    }
+
+    free(page->content);
+    page->content = NULL;
+    page->content_length = 0;
+    page->tokens = parsed->tokens;
+    page->last_token = parsed->last_token;
+    parsed->tokens = NULL;
+    parsed->last_token = NULL;
+}
+
 /// @brief Checks if a page is empty
 /// @param page the page to check if empty (must be fully initialized, e.g. using 'calloc()')
 /// @return true if page contains only the default values
@@ -86,7 +142,20 @@ bool page_is_empty(page_t *page) {
         return true;
     }
 
-    return memcmp(page, &empty_page, sizeof(empty_page)) == 0;
+    // The serial is unique for every page and is not part of its content. The fields are
+    // compared one by one, since the padding between them is not always initialized.
+    return (
+        page->id == empty_page.id &&
+        page->prev_id == empty_page.prev_id &&
+        page->next_id == empty_page.next_id &&
+        page->unix_date == empty_page.unix_date &&
+        page->title == empty_page.title &&
+        page->content == empty_page.content &&
+        page->content_length == empty_page.content_length &&
+        page->tokens == empty_page.tokens &&
+        page->last_token == empty_page.last_token &&
+        page->grid == empty_page.grid
+    );
 }
 
 void page_tokens_print(page_t *page) {
@@ -136,6 +205,10 @@ void page_token_destroy(page_token_t *token) {
 }
 
 void page_tokens_destroy(page_t *page) {
+    // The grid refers to the tokens and must not outlive them
+    grid_destroy(page->grid);
+    page->grid = NULL;
+
     if (page->tokens) {
         page_token_t *tmp;
         page_token_t *cursor = page->tokens;
@@ -154,6 +227,7 @@ void page_destroy(page_t *page) {
     }
 
     page_tokens_destroy(page);
+    free(page->content);
     free(page->title);
     free(page);
 }
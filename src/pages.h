@@ -12,6 +12,7 @@ typedef struct page page_t;
 typedef struct page_token page_token_t;
 typedef struct page_token_style page_token_style_t;
 typedef struct page_collection page_collection_t;
+typedef struct page_grid page_grid_t;
 
 typedef enum page_token_attr {
     PAGE_TOKEN_ATTR_BOLD,       // .DH
@@ -31,6 +32,11 @@ typedef enum page_token_attr {
     PAGE_TOKEN_ATTR_NONE = -1
 } page_token_attr_t;
 
+#define PAGE_TOKEN_ATTR_FG_FIRST PAGE_TOKEN_ATTR_BLUE
+#define PAGE_TOKEN_ATTR_FG_LAST  PAGE_TOKEN_ATTR_RED
+#define PAGE_TOKEN_ATTR_BG_FIRST PAGE_TOKEN_ATTR_BG_BLACK
+#define PAGE_TOKEN_ATTR_BG_LAST  PAGE_TOKEN_ATTR_BG_RED
+
 typedef enum page_token_type {
     PAGE_TOKEN_HEADER,          // .toprow
     PAGE_TOKEN_TEXT,            // any text content inside tags
@@ -49,15 +55,20 @@ struct page_token {
     uint8_t length;
     page_token_type_t type;
     page_token_style_t style;
+    uint32_t attr;              // display attributes, 0 until resolved by 'colors_resolve_page()'
     page_token_t *next;
 };
 
 struct page {
+    uint32_t serial;            // unique for every created page, 0 for empty pages
     char *title;
     uint16_t id, prev_id, next_id;
     uint64_t unix_date;
+    char *content;              // the HTML content until it is parsed, see 'page_get_tokens()'
+    size_t content_length;
     page_token_t *tokens;
     page_token_t *last_token;
+    page_grid_t *grid;          // laid out lazily, see 'grid_get()'
 };
 
 struct page_collection {
@@ -70,6 +81,9 @@ page_token_t *page_token_create_empty();
 page_collection_t *page_collection_create(size_t size);
 bool page_is_empty(page_t *page);
 void page_collection_resize(page_collection_t *collection, size_t new_size);
+page_token_t *page_get_tokens(page_t *page);
+bool page_is_tokenized(page_t *page);
+void page_move_tokens(page_t *page, page_t *parsed);
 void page_destroy(page_t *page);
 void page_token_destroy(page_token_t *token);
 void page_tokens_destroy(page_t *page);
@@ -3,7 +3,6 @@
 #define JSMN_PARENT_LINKS
 #include "../lib/jsmn.h"
 
-#define TOKENS_SIZE 256
 #define ESCAPED_CHAR_SEQUENCE_LENGTH 5
 
 static void next_token(jsmntok_t **cursor) {
@@ -19,6 +18,16 @@ static void next_n_token(jsmntok_t **cursor, size_t n) {
     }
 }
 
+/// @brief Moves the cursor to the last token of the value at the cursor,
+///        i.e. past any arrays or objects inside it
+static void skip_value(jsmntok_t **cursor, jsmntok_t *end) {
+    int value_end = (*cursor)->end;
+
+    while (*cursor + 1 < end && (*cursor + 1)->start < value_end) {
+        next_token(cursor);
+    }
+}
+
 static size_t token_length(jsmntok_t *cursor) {
     if (!cursor) {
         return 0;
@@ -96,15 +105,15 @@ static void parse_content(page_t *page, const char *data, jsmntok_t **cursor) {
 
     // TODO: Add support for more than one element?
     //       For certain pages, there are a "sub" page with other data, e.g. the stock market page
-    // Go to the first array element
+    // Go to the first array element. The HTML is parsed when the page is used, since
+    // most of the pages that are fetched, e.g. prefetched or in ranges, are never shown.
     next_token(cursor);
-    char *html = get_string(data, *cursor);
-    html_parser_get_page_tokens(page, html, token_length(*cursor));
+    page->content = get_string(data, *cursor);
+    page->content_length = page->content ? token_length(*cursor) : 0;
     next_n_token(cursor, array_size - 1);
-    free(html);
 }
 
-static page_t *get_page(const char *data, jsmntok_t **cursor) {
+static page_t *get_page(const char *data, jsmntok_t **cursor, jsmntok_t *end) {
     char *key = NULL;
     size_t keys = (*cursor)->size;
 
@@ -123,8 +132,10 @@ static page_t *get_page(const char *data, jsmntok_t **cursor) {
         next_token(cursor);
         key = get_string(data, *cursor);
         next_token(cursor);
+        jsmntok_t *value = *cursor;
 
         if (!key) {
+            skip_value(cursor, end);
             continue;
         }
 
@@ -142,46 +153,169 @@ static page_t *get_page(const char *data, jsmntok_t **cursor) {
             parse_content(page, data, cursor);
         }
 
+        // Unknown keys might have arrays or objects as values
+        *cursor = value;
+        skip_value(cursor, end);
         free(key);
     }
 
     return page;
 }
 
-page_t *parser_get_page(const char *data, size_t size) {
+/// @brief Splits the response data into JSON tokens
+/// @param tokens set to the tokens, which must be free'd by the caller
+/// @return the number of tokens or 0 if the data could not be parsed
+static int get_tokens(const char *data, size_t size, jsmntok_t **tokens) {
+    *tokens = NULL;
+
     if (!data || *data == '\0' || size == 0) {
         error_set_with_string(
             TTT_ERROR_PAGE_PARSER_FAILED,
             "ERROR: Could not parse empty response data"
         );
-        return NULL;
+        return 0;
     }
 
+    // Count the tokens first, a range of pages can have any number of tokens
     jsmn_parser parser;
     jsmn_init(&parser);
-    jsmntok_t tokens[TOKENS_SIZE];
-    size_t keys = jsmn_parse(&parser, data, size, tokens, sizeof(tokens) / sizeof(tokens[0]));
+    int count = jsmn_parse(&parser, data, size, NULL, 0);
 
-    if (keys < 3 || tokens[0].type != JSMN_ARRAY || tokens[1].type != JSMN_OBJECT) {
+    if (count <= 0) {
         error_set_with_string(
             TTT_ERROR_PAGE_PARSER_FAILED,
             "ERROR: Could not parse response data with invalid structure"
         );
+        return 0;
+    }
+
+    *tokens = malloc(count * sizeof(jsmntok_t));
+
+    if (!*tokens) {
+        error_set(TTT_ERROR_OUT_OF_MEMORY);
+        return 0;
+    }
+
+    // Incomplete data is only detected when the tokens are stored
+    jsmn_init(&parser);
+    count = jsmn_parse(&parser, data, size, *tokens, count);
+
+    if (count <= 0) {
+        error_set_with_string(
+            TTT_ERROR_PAGE_PARSER_FAILED,
+            "ERROR: Could not parse response data with invalid structure"
+        );
+        free(*tokens);
+        *tokens = NULL;
+        return 0;
+    }
+
+    return count;
+}
+
+page_t *parser_get_page(const char *data, size_t size) {
+    jsmntok_t *tokens;
+    int count = get_tokens(data, size, &tokens);
+
+    if (count < 3 || tokens[0].type != JSMN_ARRAY || tokens[1].type != JSMN_OBJECT) {
+        if (count > 0) {
+            error_set_with_string(
+                TTT_ERROR_PAGE_PARSER_FAILED,
+                "ERROR: Could not parse response data with invalid structure"
+            );
+        }
+
+        free(tokens);
         return NULL;
     }
 
     jsmntok_t *cursor = tokens;
     next_token(&cursor);
 
-    // We only parse single pages, even if there are more than
-    // one page in the response data
-    if (cursor->type == JSMN_OBJECT) {
-        page_t *page = get_page(data, &cursor);
+    // Only the first page is parsed, even if there are more than
+    // one page in the response data, see 'parser_get_page_collection()'
+    page_t *page = get_page(data, &cursor, tokens + count);
+    free(tokens);
+    return page;
+}
+
+/// @brief Parses every page in the response data, e.g. the response of a range of pages.
+///        Elements that are not valid pages are skipped.
+/// @return the pages or NULL if the response data is invalid
+page_collection_t *parser_get_page_collection(const char *data, size_t size) {
+    jsmntok_t *tokens;
+    int count = get_tokens(data, size, &tokens);
+
+    if (count < 1 || tokens[0].type != JSMN_ARRAY) {
+        if (count > 0) {
+            error_set_with_string(
+                TTT_ERROR_PAGE_PARSER_FAILED,
+                "ERROR: Could not parse response data with invalid structure"
+            );
+        }
+
+        free(tokens);
+        return NULL;
+    }
+
+    page_collection_t *collection = page_collection_create(0);
+    jsmntok_t *end = tokens + count;
+    jsmntok_t *cursor = tokens;
+
+    for (int i = 0; i < tokens[0].size; i++) {
+        next_token(&cursor);
+        jsmntok_t *element = cursor;
+        page_t *page = element->type == JSMN_OBJECT ? get_page(data, &cursor, end) : NULL;
 
         if (page) {
-            return page;
+            size_t size = collection->size;
+            page_collection_resize(collection, size + 1);
+
+            if (collection->size == size) {
+                page_destroy(page);
+            } else {
+                collection->pages[size] = page;
+            }
         }
+
+        cursor = element;
+        skip_value(&cursor, end);
+    }
+
+    free(tokens);
+    return collection;
+}
+
+/// @brief Finds the JSON object of every page in the response data without parsing
+///        the pages, e.g. to store each page of a range of pages by itself
+/// @return the number of pages that were found, at most 'max_sources'
+size_t parser_get_page_sources(const char *data, size_t size, parser_source_t *sources, size_t max_sources) {
+    jsmntok_t *tokens;
+    int count = get_tokens(data, size, &tokens);
+
+    if (count < 1 || tokens[0].type != JSMN_ARRAY) {
+        free(tokens);
+        return 0;
+    }
+
+    jsmntok_t *end = tokens + count;
+    jsmntok_t *cursor = tokens;
+    size_t found = 0;
+
+    for (int i = 0; i < tokens[0].size && found < max_sources; i++) {
+        next_token(&cursor);
+
+        if (cursor->type == JSMN_OBJECT) {
+            sources[found] = (parser_source_t) {
+                .data = data + cursor->start,
+                .size = cursor->end - cursor->start
+            };
+            found++;
+        }
+
+        skip_value(&cursor, end);
     }
 
-    return NULL;
+    free(tokens);
+    return found;
 }
@@ -12,4 +12,11 @@
 #include "errors.h"
 #include "html_parser.h"
 
+typedef struct parser_source {
+    const char *data;           // the JSON object of a page, inside the response data
+    size_t size;
+} parser_source_t;
+
 page_t *parser_get_page(const char *data, size_t size);
+page_collection_t *parser_get_page_collection(const char *data, size_t size);
+size_t parser_get_page_sources(const char *data, size_t size, parser_source_t *sources, size_t max_sources);
@@ -0,0 +1,47 @@
+#include "queue.h"
+
+// The nodes are pushed onto a stack with compare-and-swap. The consumer takes
+// the whole stack with a single exchange, so a node is never removed while
+// another thread reads it, and then reverses it into the order it was pushed in.
+
+void queue_initialize(queue_t *queue) {
+    atomic_init(&queue->head, NULL);
+}
+
+/// @brief Adds a node to the queue, from any thread
+/// @return true if the queue was empty, i.e. if the consumer has to be woken up
+bool queue_push(queue_t *queue, queue_node_t *node) {
+    queue_node_t *head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+    do {
+        node->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(
+                 &queue->head,
+                 &head,
+                 node,
+                 memory_order_release,
+                 memory_order_relaxed
+             ));
+
+    return head == NULL;
+}
+
+/// @brief Takes every node in the queue, only from the consuming thread
+/// @return the oldest node, the rest follow in the order they were pushed, or NULL if empty
+queue_node_t *queue_take_all(queue_t *queue) {
+    queue_node_t *node = atomic_exchange_explicit(&queue->head, NULL, memory_order_acquire);
+    queue_node_t *first = NULL;
+
+    while (node) {
+        queue_node_t *next = node->next;
+        node->next = first;
+        first = node;
+        node = next;
+    }
+
+    return first;
+}
+
+bool queue_is_empty(queue_t *queue) {
+    return atomic_load_explicit(&queue->head, memory_order_relaxed) == NULL;
+}
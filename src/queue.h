@@ -0,0 +1,21 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/// @brief Embedded in the items of a queue, so that pushing never allocates
+typedef struct queue_node {
+    struct queue_node *next;
+} queue_node_t;
+
+/// @brief A lock-free queue that any thread can push to, but only one thread takes from
+typedef struct queue {
+    _Atomic(queue_node_t *) head;   // the last pushed node
+} queue_t;
+
+void queue_initialize(queue_t *queue);
+bool queue_push(queue_t *queue, queue_node_t *node);
+queue_node_t *queue_take_all(queue_t *queue);
+bool queue_is_empty(queue_t *queue);
@@ -0,0 +1,201 @@
+#include "scheduler.h"
+
+// The entries that can run at the same time for each priority. The page that the
+// user is waiting for can use every slot, while the rest leave one of them free
+// for it, so that it never has to wait for a prefetch to complete. Local work
+// makes no requests, so it is neither limited here nor by the rate limit.
+static const int max_running[SCHEDULER_PRIORITY_COUNT] = {
+    [SCHEDULER_PRIORITY_VISIBLE] = INT32_MAX,
+    [SCHEDULER_PRIORITY_TYPED] = 2,
+    [SCHEDULER_PRIORITY_PREFETCH] = 2,
+    [SCHEDULER_PRIORITY_LOCAL] = INT32_MAX,
+    [SCHEDULER_PRIORITY_REVALIDATE] = 1,
+    [SCHEDULER_PRIORITY_CRAWL] = 1
+};
+
+static void refill_tokens(scheduler_t *scheduler, uint64_t now_ms) {
+    if (now_ms <= scheduler->refilled_ms) {
+        return;
+    }
+
+    double elapsed = (now_ms - scheduler->refilled_ms) / 1000.0;
+    scheduler->tokens += elapsed * scheduler->tokens_per_second;
+    scheduler->refilled_ms = now_ms;
+
+    if (scheduler->tokens > scheduler->max_tokens) {
+        scheduler->tokens = scheduler->max_tokens;
+    }
+}
+
+static int count_background_running(scheduler_t *scheduler) {
+    int count = 0;
+
+    for (int i = SCHEDULER_PRIORITY_VISIBLE + 1; i < SCHEDULER_PRIORITY_COUNT; i++) {
+        count += scheduler->running[i];
+    }
+
+    return count;
+}
+
+static bool can_take(scheduler_t *scheduler, scheduler_priority_t priority) {
+    if (scheduler->running[priority] >= max_running[priority]) {
+        return false;
+    }
+
+    if (priority == SCHEDULER_PRIORITY_VISIBLE) {
+        return true;
+    }
+
+    if (count_background_running(scheduler) >= scheduler->slots - 1) {
+        return false;
+    }
+
+    return !scheduler_yields_to_visible(priority) || (
+        !scheduler->first[SCHEDULER_PRIORITY_VISIBLE] &&
+        !scheduler->running[SCHEDULER_PRIORITY_VISIBLE]
+    );
+}
+
+/// @param slots the number of entries that can run at the same time
+/// @param tokens_per_second how many entries can be started each second over time
+/// @param max_tokens how many entries can be started at once after waiting
+void scheduler_initialize(scheduler_t *scheduler, int slots, double tokens_per_second, double max_tokens) {
+    memset(scheduler, 0, sizeof(scheduler_t));
+    scheduler->slots = slots;
+    scheduler->tokens = max_tokens;
+    scheduler->tokens_per_second = tokens_per_second;
+    scheduler->max_tokens = max_tokens;
+}
+
+/// @brief Adds an entry last among the waiting entries with the same priority
+void scheduler_add(scheduler_t *scheduler, scheduler_entry_t *entry, scheduler_priority_t priority) {
+    entry->next = NULL;
+    entry->priority = priority;
+    entry->waiting = true;
+
+    if (scheduler->last[priority]) {
+        scheduler->last[priority]->next = entry;
+    } else {
+        scheduler->first[priority] = entry;
+    }
+
+    scheduler->last[priority] = entry;
+}
+
+/// @brief Adds an entry that was taken back first among the entries with the same priority
+void scheduler_requeue(scheduler_t *scheduler, scheduler_entry_t *entry) {
+    scheduler_priority_t priority = entry->priority;
+    entry->next = scheduler->first[priority];
+    entry->waiting = true;
+    scheduler->first[priority] = entry;
+
+    if (!scheduler->last[priority]) {
+        scheduler->last[priority] = entry;
+    }
+}
+
+/// @brief Removes an entry that is waiting
+void scheduler_remove(scheduler_t *scheduler, scheduler_entry_t *entry) {
+    scheduler_priority_t priority = entry->priority;
+    scheduler_entry_t *previous = NULL;
+    scheduler_entry_t *current = scheduler->first[priority];
+
+    while (current && current != entry) {
+        previous = current;
+        current = current->next;
+    }
+
+    if (!current) {
+        return;
+    }
+
+    if (previous) {
+        previous->next = entry->next;
+    } else {
+        scheduler->first[priority] = entry->next;
+    }
+
+    if (scheduler->last[priority] == entry) {
+        scheduler->last[priority] = previous;
+    }
+
+    entry->next = NULL;
+    entry->waiting = false;
+}
+
+/// @brief Moves an entry that has been added or taken to a higher priority
+void scheduler_promote(scheduler_t *scheduler, scheduler_entry_t *entry, scheduler_priority_t priority) {
+    if (priority >= entry->priority) {
+        return;
+    }
+
+    if (entry->waiting) {
+        scheduler_remove(scheduler, entry);
+        scheduler_add(scheduler, entry, priority);
+    } else {
+        scheduler->running[entry->priority]--;
+        scheduler->running[priority]++;
+        entry->priority = priority;
+    }
+}
+
+/// @brief Takes the waiting entry with the highest priority that is allowed to run
+/// @param now_ms the current time of a monotonic clock
+/// @param wait_ms set to when an entry can be taken if it is only waiting for the rate limit,
+///        or 0 if it has to wait for another entry to be added or finished
+/// @return NULL if no entry can run yet
+scheduler_entry_t *scheduler_take(scheduler_t *scheduler, uint64_t now_ms, uint64_t *wait_ms) {
+    refill_tokens(scheduler, now_ms);
+    *wait_ms = 0;
+
+    for (int i = 0; i < SCHEDULER_PRIORITY_COUNT; i++) {
+        scheduler_entry_t *entry = scheduler->first[i];
+
+        if (!entry || !can_take(scheduler, i)) {
+            continue;
+        }
+
+        // The page that the user is waiting for is never delayed by the rate limit. It
+        // still takes a token, even if there are none left, to hold back the rest.
+        if (i != SCHEDULER_PRIORITY_VISIBLE && i != SCHEDULER_PRIORITY_LOCAL && scheduler->tokens < 1) {
+            uint64_t refill_ms = (1 - scheduler->tokens) * 1000 / scheduler->tokens_per_second + 1;
+            *wait_ms = !*wait_ms || refill_ms < *wait_ms ? refill_ms : *wait_ms;
+            continue;
+        }
+
+        if (i != SCHEDULER_PRIORITY_LOCAL) {
+            scheduler->tokens--;
+        }
+
+        scheduler_remove(scheduler, entry);
+        scheduler->running[i]++;
+        return entry;
+    }
+
+    return NULL;
+}
+
+/// @brief Frees the slot of an entry that was taken
+void scheduler_finish(scheduler_t *scheduler, scheduler_entry_t *entry) {
+    scheduler->running[entry->priority]--;
+}
+
+/// @brief Gives back the token of an entry that was taken, but did not make a request
+///        after all, e.g. since the page could be read from the store
+void scheduler_refund(scheduler_t *scheduler, scheduler_entry_t *entry) {
+    if (entry->priority == SCHEDULER_PRIORITY_LOCAL) {
+        return;
+    }
+
+    scheduler->tokens++;
+
+    if (scheduler->tokens > scheduler->max_tokens) {
+        scheduler->tokens = scheduler->max_tokens;
+    }
+}
+
+/// @brief Whether entries with the priority wait, or should be stopped and requeued,
+///        while the page that the user is waiting for is requested
+bool scheduler_yields_to_visible(scheduler_priority_t priority) {
+    return priority >= SCHEDULER_PRIORITY_REVALIDATE;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+typedef enum scheduler_priority {
+    SCHEDULER_PRIORITY_VISIBLE,     // the page that the user is waiting for
+    SCHEDULER_PRIORITY_TYPED,       // the pages that a partially typed page number can end up as
+    SCHEDULER_PRIORITY_PREFETCH,    // the pages that the user will probably go to next
+    SCHEDULER_PRIORITY_LOCAL,       // work without requests, e.g. parsing the pages for a search
+    SCHEDULER_PRIORITY_REVALIDATE,  // updates of pages that have been shown
+    SCHEDULER_PRIORITY_CRAWL,       // pages that are only indexed or stored
+    SCHEDULER_PRIORITY_COUNT
+} scheduler_priority_t;
+
+/// @brief Embedded in the jobs that are scheduled
+typedef struct scheduler_entry {
+    struct scheduler_entry *next;
+    scheduler_priority_t priority;
+    bool waiting;
+} scheduler_entry_t;
+
+typedef struct scheduler {
+    scheduler_entry_t *first[SCHEDULER_PRIORITY_COUNT];
+    scheduler_entry_t *last[SCHEDULER_PRIORITY_COUNT];
+    int running[SCHEDULER_PRIORITY_COUNT];
+    int slots;                  // the number of entries that can run at the same time
+    double tokens;
+    double tokens_per_second;
+    double max_tokens;
+    uint64_t refilled_ms;
+} scheduler_t;
+
+void scheduler_initialize(scheduler_t *scheduler, int slots, double tokens_per_second, double max_tokens);
+void scheduler_add(scheduler_t *scheduler, scheduler_entry_t *entry, scheduler_priority_t priority);
+void scheduler_requeue(scheduler_t *scheduler, scheduler_entry_t *entry);
+void scheduler_remove(scheduler_t *scheduler, scheduler_entry_t *entry);
+void scheduler_promote(scheduler_t *scheduler, scheduler_entry_t *entry, scheduler_priority_t priority);
+scheduler_entry_t *scheduler_take(scheduler_t *scheduler, uint64_t now_ms, uint64_t *wait_ms);
+void scheduler_finish(scheduler_t *scheduler, scheduler_entry_t *entry);
+void scheduler_refund(scheduler_t *scheduler, scheduler_entry_t *entry);
+bool scheduler_yields_to_visible(scheduler_priority_t priority);
@@ -0,0 +1,388 @@
+#include "search.h"
+
+#define INITIAL_TERM_CAPACITY 1024
+#define EXACT_MATCH_WEIGHT    2
+
+typedef struct posting {
+    uint16_t page_id;
+    uint16_t count;             // the number of times the term is on the page
+} posting_t;
+
+typedef struct term {
+    char *word;
+    posting_t *postings;
+    size_t posting_count;
+    size_t posting_capacity;
+} term_t;
+
+typedef struct page_terms {
+    uint32_t *terms;            // the terms that are on the page, to remove it again
+    size_t count;
+    size_t capacity;
+    bool indexed;
+} page_terms_t;
+
+// An inverted index from the words on the pages to the pages that they are on.
+// The terms are kept in a hash table with open addressing, and every page
+// remembers its terms so that it can be reindexed when it has been updated.
+struct search_index {
+    term_t *terms;
+    size_t term_count;
+    size_t term_capacity;
+    uint32_t *table;            // term index + 1, 0 for empty slots
+    size_t table_size;
+    page_terms_t pages[SEARCH_MAX_PAGE_ID + 1];
+    size_t page_count;
+};
+
+static uint32_t hash_word(const char *word) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+
+    for (; *word != '\0'; word++) {
+        hash = (hash ^ (unsigned char)*word) * 16777619u;
+    }
+
+    return hash;
+}
+
+static bool append(void **items, size_t *count, size_t *capacity, size_t item_size) {
+    if (*count < *capacity) {
+        return true;
+    }
+
+    size_t new_capacity = *capacity ? *capacity * 2 : 4;
+    void *new_items = realloc(*items, new_capacity * item_size);
+
+    if (!new_items) {
+        error_set(TTT_ERROR_OUT_OF_MEMORY);
+        return false;
+    }
+
+    *items = new_items;
+    *capacity = new_capacity;
+    return true;
+}
+
+static bool grow_table(search_index_t *index) {
+    size_t table_size = index->table_size ? index->table_size * 2 : INITIAL_TERM_CAPACITY;
+    uint32_t *table = calloc(table_size, sizeof(uint32_t));
+
+    if (!table) {
+        error_set(TTT_ERROR_OUT_OF_MEMORY);
+        return false;
+    }
+
+    for (size_t i = 0; i < index->term_count; i++) {
+        size_t slot = hash_word(index->terms[i].word) & (table_size - 1);
+
+        while (table[slot]) {
+            slot = (slot + 1) & (table_size - 1);
+        }
+
+        table[slot] = i + 1;
+    }
+
+    free(index->table);
+    index->table = table;
+    index->table_size = table_size;
+    return true;
+}
+
+/// @return the index of the term, which is added if it does not exist, or -1 if out of memory
+static int64_t get_term(search_index_t *index, const char *word) {
+    // Keep the table at most half full
+    if ((index->term_count + 1) * 2 > index->table_size && !grow_table(index)) {
+        return -1;
+    }
+
+    size_t slot = hash_word(word) & (index->table_size - 1);
+
+    while (index->table[slot]) {
+        uint32_t term = index->table[slot] - 1;
+
+        if (strcmp(index->terms[term].word, word) == 0) {
+            return term;
+        }
+
+        slot = (slot + 1) & (index->table_size - 1);
+    }
+
+    if (!append((void **)&index->terms, &index->term_count, &index->term_capacity, sizeof(term_t))) {
+        return -1;
+    }
+
+    term_t *term = &index->terms[index->term_count];
+    memset(term, 0, sizeof(term_t));
+    term->word = malloc(strlen(word) + 1);
+
+    if (!term->word) {
+        error_set(TTT_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    strcpy(term->word, word);
+
+    index->table[slot] = index->term_count + 1;
+    return index->term_count++;
+}
+
+static bool add_word(search_index_t *index, uint16_t page_id, const char *word) {
+    int64_t term_index = get_term(index, word);
+
+    if (term_index == -1) {
+        return false;
+    }
+
+    term_t *term = &index->terms[term_index];
+
+    // The postings of a page are added together, so the page can only be the last one
+    if (term->posting_count > 0 && term->postings[term->posting_count - 1].page_id == page_id) {
+        term->postings[term->posting_count - 1].count++;
+        return true;
+    }
+
+    page_terms_t *page = &index->pages[page_id];
+
+    if (
+        !append((void **)&term->postings, &term->posting_count, &term->posting_capacity, sizeof(posting_t)) ||
+        !append((void **)&page->terms, &page->count, &page->capacity, sizeof(uint32_t))
+    ) {
+        return false;
+    }
+
+    term->postings[term->posting_count] = (posting_t) {
+        .page_id = page_id,
+        .count = 1
+    };
+    term->posting_count++;
+    page->terms[page->count] = term_index;
+    page->count++;
+    return true;
+}
+
+/// @brief Reads the next word, i.e. letters and digits, in lower case
+/// @return the position after the word or NULL if there are no more words
+static const char *next_word(const char *str, char word[SEARCH_WORD_SIZE]) {
+    while (*str != '\0' && !isalnum((unsigned char)*str)) {
+        str++;
+    }
+
+    if (*str == '\0') {
+        return NULL;
+    }
+
+    size_t length = 0;
+
+    for (; isalnum((unsigned char)*str); str++) {
+        // Long words are truncated
+        if (length < SEARCH_WORD_SIZE - 1) {
+            word[length] = tolower((unsigned char)*str);
+            length++;
+        }
+    }
+
+    word[length] = '\0';
+    return str;
+}
+
+search_index_t *search_create() {
+    search_index_t *index = calloc(1, sizeof(search_index_t));
+
+    if (!index) {
+        error_set(TTT_ERROR_OUT_OF_MEMORY);
+    }
+
+    return index;
+}
+
+/// @brief Adds the words on a page to the index, replacing the words
+///        of the page if it has been indexed before
+bool search_add_page(search_index_t *index, page_t *page) {
+    if (!index || !page || page->id > SEARCH_MAX_PAGE_ID) {
+        return false;
+    }
+
+    search_remove_page(index, page->id);
+    char word[SEARCH_WORD_SIZE];
+    size_t length = 0;
+
+    // Words can continue in the next token, e.g. if only a part of a word is a link
+    for (page_token_t *token = page_get_tokens(page); token; token = token->next) {
+        for (const char *c = token->text; c && *c != '\0'; c++) {
+            if (isalnum((unsigned char)*c)) {
+                if (length < SEARCH_WORD_SIZE - 1) {
+                    word[length] = tolower((unsigned char)*c);
+                    length++;
+                }
+
+                continue;
+            }
+
+            if (length > 0) {
+                word[length] = '\0';
+                length = 0;
+
+                if (!add_word(index, page->id, word)) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    if (length > 0) {
+        word[length] = '\0';
+
+        if (!add_word(index, page->id, word)) {
+            return false;
+        }
+    }
+
+    index->pages[page->id].indexed = true;
+    index->page_count++;
+    return true;
+}
+
+void search_remove_page(search_index_t *index, uint16_t page_id) {
+    if (!index || page_id > SEARCH_MAX_PAGE_ID) {
+        return;
+    }
+
+    page_terms_t *page = &index->pages[page_id];
+
+    for (size_t i = 0; i < page->count; i++) {
+        term_t *term = &index->terms[page->terms[i]];
+
+        for (size_t j = 0; j < term->posting_count; j++) {
+            if (term->postings[j].page_id == page_id) {
+                term->posting_count--;
+                memmove(&term->postings[j], &term->postings[j + 1], (term->posting_count - j) * sizeof(posting_t));
+                break;
+            }
+        }
+    }
+
+    // Terms that are no longer on any page are kept, they are likely to come back
+    page->count = 0;
+
+    if (page->indexed) {
+        page->indexed = false;
+        index->page_count--;
+    }
+}
+
+bool search_contains_page(search_index_t *index, uint16_t page_id) {
+    return index && page_id <= SEARCH_MAX_PAGE_ID && index->pages[page_id].indexed;
+}
+
+/// @brief Splits a query into lower case words
+/// @return the number of words, at most SEARCH_MAX_WORDS
+size_t search_get_words(const char *query, char words[SEARCH_MAX_WORDS][SEARCH_WORD_SIZE]) {
+    size_t count = 0;
+
+    while (query && count < SEARCH_MAX_WORDS && (query = next_word(query, words[count]))) {
+        count++;
+    }
+
+    return count;
+}
+
+static int compare_hits(const void *a, const void *b) {
+    const search_hit_t *first = a;
+    const search_hit_t *second = b;
+
+    if (first->score != second->score) {
+        return first->score < second->score ? 1 : -1;
+    }
+
+    return (int)first->page_id - (int)second->page_id;
+}
+
+/// @brief Finds the pages that contain every word in the query. The words match
+///        the start of the words on the pages, e.g. "djur" matches "djurgarden".
+///        The pages are ranked by how many times the words are on them,
+///        where whole words count more than the start of a word.
+/// @return the number of hits, at most 'max_hits'
+size_t search_query(search_index_t *index, const char *query, search_hit_t *hits, size_t max_hits) {
+    char words[SEARCH_MAX_WORDS][SEARCH_WORD_SIZE];
+    size_t word_count = search_get_words(query, words);
+
+    if (!index || word_count == 0) {
+        return 0;
+    }
+
+    unsigned int scores[SEARCH_MAX_PAGE_ID + 1] = {0};
+    uint8_t matched_words[SEARCH_MAX_PAGE_ID + 1] = {0};
+
+    for (size_t w = 0; w < word_count; w++) {
+        size_t length = strlen(words[w]);
+        // Only count each word once per page, even if it is the start of several terms
+        bool matched[SEARCH_MAX_PAGE_ID + 1] = {false};
+
+        for (size_t t = 0; t < index->term_count; t++) {
+            term_t *term = &index->terms[t];
+
+            if (term->posting_count == 0 || strncmp(term->word, words[w], length) != 0) {
+                continue;
+            }
+
+            unsigned int weight = term->word[length] == '\0' ? EXACT_MATCH_WEIGHT : 1;
+
+            for (size_t p = 0; p < term->posting_count; p++) {
+                posting_t *posting = &term->postings[p];
+                scores[posting->page_id] += posting->count * weight;
+
+                if (!matched[posting->page_id]) {
+                    matched[posting->page_id] = true;
+                    matched_words[posting->page_id]++;
+                }
+            }
+        }
+    }
+
+    size_t hit_count = 0;
+    search_hit_t all_hits[SEARCH_MAX_PAGE_ID + 1];
+
+    for (uint16_t id = 0; id <= SEARCH_MAX_PAGE_ID; id++) {
+        if (matched_words[id] == word_count) {
+            all_hits[hit_count] = (search_hit_t) {
+                .page_id = id,
+                .score = scores[id]
+            };
+            hit_count++;
+        }
+    }
+
+    qsort(all_hits, hit_count, sizeof(search_hit_t), compare_hits);
+
+    if (hit_count > max_hits) {
+        hit_count = max_hits;
+    }
+
+    memcpy(hits, all_hits, hit_count * sizeof(search_hit_t));
+    return hit_count;
+}
+
+/// @brief Returns the number of pages that have been indexed
+size_t search_get_page_count(search_index_t *index) {
+    return index ? index->page_count : 0;
+}
+
+void search_destroy(search_index_t *index) {
+    if (!index) {
+        return;
+    }
+
+    for (size_t i = 0; i < index->term_count; i++) {
+        free(index->terms[i].word);
+        free(index->terms[i].postings);
+    }
+
+    for (int i = 0; i <= SEARCH_MAX_PAGE_ID; i++) {
+        free(index->pages[i].terms);
+    }
+
+    free(index->terms);
+    free(index->table);
+    free(index);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "pages.h"
+#include "errors.h"
+
+// Every page id that can be indexed, see CACHE_MAX_PAGE_ID
+#define SEARCH_MAX_PAGE_ID  999
+#define SEARCH_WORD_SIZE    32
+#define SEARCH_MAX_WORDS    8
+
+typedef struct search_index search_index_t;
+
+typedef struct search_hit {
+    uint16_t page_id;
+    unsigned int score;
+} search_hit_t;
+
+search_index_t *search_create();
+bool search_add_page(search_index_t *index, page_t *page);
+void search_remove_page(search_index_t *index, uint16_t page_id);
+bool search_contains_page(search_index_t *index, uint16_t page_id);
+size_t search_query(search_index_t *index, const char *query, search_hit_t *hits, size_t max_hits);
+size_t search_get_page_count(search_index_t *index);
+size_t search_get_words(const char *query, char words[SEARCH_MAX_WORDS][SEARCH_WORD_SIZE]);
+void search_destroy(search_index_t *index);
@@ -0,0 +1,275 @@
+#include "store.h"
+
+// Pages are stored on disk as they were received from the API, one file per
+// page, so that they can be shown when the API can not be reached.
+struct page_store {
+    char path[PATH_MAX];
+};
+
+static bool get_file_path(page_store_t *store, uint16_t id, const char *suffix, char *buf, size_t buf_size) {
+    int length = snprintf(buf, buf_size, "%s/%d.json%s", store->path, id, suffix);
+    return length > 0 && (size_t)length < buf_size;
+}
+
+/// @brief Creates a directory and its parents, like 'mkdir -p'
+static bool create_directories(char *path) {
+    for (char *c = path + 1; ; c++) {
+        if (*c != '/' && *c != '\0') {
+            continue;
+        }
+
+        char separator = *c;
+        *c = '\0';
+        bool created = mkdir(path, 0700) == 0 || access(path, W_OK | X_OK) == 0;
+        *c = separator;
+
+        if (!created || separator == '\0') {
+            return created;
+        }
+    }
+}
+
+/// @brief Opens the page store in a directory, which is created if it does not exist
+/// @param path the directory or NULL for the user's cache directory, e.g. ~/.cache/ttt
+/// @return the store or NULL if the directory could not be created
+page_store_t *store_open(const char *path) {
+    page_store_t *store = calloc(1, sizeof(page_store_t));
+
+    if (!store) {
+        error_set(TTT_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    const char *cache_home = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    int length;
+
+    if (path) {
+        length = snprintf(store->path, PATH_MAX, "%s", path);
+    } else if (cache_home && *cache_home != '\0') {
+        length = snprintf(store->path, PATH_MAX, "%s/%s", cache_home, STORE_DIR_NAME);
+    } else if (home && *home != '\0') {
+        length = snprintf(store->path, PATH_MAX, "%s/.cache/%s", home, STORE_DIR_NAME);
+    } else {
+        length = -1;
+    }
+
+    if (length <= 0 || length >= PATH_MAX || !create_directories(store->path)) {
+        free(store);
+        error_set(TTT_ERROR_STORE_FAILED);
+        return NULL;
+    }
+
+    return store;
+}
+
+/// @brief Stores a page, replacing the stored version of it
+/// @param source the JSON object of the page, see 'parser_get_page_sources()'
+bool store_put(page_store_t *store, uint16_t id, const char *source, size_t size) {
+    char path[PATH_MAX];
+    char temporary_path[PATH_MAX];
+
+    if (
+        !store ||
+        !get_file_path(store, id, "", path, PATH_MAX) ||
+        !get_file_path(store, id, ".tmp", temporary_path, PATH_MAX)
+    ) {
+        return false;
+    }
+
+    FILE *file = fopen(temporary_path, "w");
+
+    if (!file) {
+        error_set(TTT_ERROR_STORE_FAILED);
+        return false;
+    }
+
+    // The API responds with an array of pages, which is what the parser expects
+    bool written = fputc('[', file) != EOF && fwrite(source, 1, size, file) == size && fputc(']', file) != EOF;
+    written = fclose(file) == 0 && written;
+
+    // Replace the file in one step, so that a page is never partially written
+    if (!written || rename(temporary_path, path) != 0) {
+        remove(temporary_path);
+        error_set(TTT_ERROR_STORE_FAILED);
+        return false;
+    }
+
+    return true;
+}
+
+/// @brief Reads and parses a stored page
+/// @param stored_at set to the time that the page was stored, may be NULL
+/// @return the page or NULL if it has not been stored
+/// @brief Parses a single page from a range response, as if it was the whole response
+static page_t *parse_source(parser_source_t *source) {
+    // The parser expects an array of pages, like the API responds with
+    char *data = malloc(source->size + 3);
+
+    if (!data) {
+        return NULL;
+    }
+
+    data[0] = '[';
+    memcpy(data + 1, source->data, source->size);
+    data[source->size + 1] = ']';
+    data[source->size + 2] = '\0';
+    page_t *page = parser_get_page(data, source->size + 2);
+    free(data);
+    return page;
+}
+
+/// @brief Stores the pages between start and end from the response of a range request.
+///        Only the first subpage of each page is stored, see 'parser_get_page()'.
+/// @return the pages that were stored, or NULL if there was not enough memory
+page_collection_t *store_put_range(page_store_t *store, uint16_t start, uint16_t end, const char *data, size_t size) {
+    // Range responses include every subpage, so there can be more sources than page numbers
+    size_t max_sources = (end - start + 1) * STORE_MAX_SUBPAGES;
+    parser_source_t *sources = malloc(max_sources * sizeof(parser_source_t));
+    size_t count = sources ? parser_get_page_sources(data, size, sources, max_sources) : 0;
+    page_collection_t *pages = sources ? page_collection_create(count) : NULL;
+    uint16_t last_id = 0;
+    size_t stored = 0;
+
+    for (size_t i = 0; pages && i < count; i++) {
+        page_t *page = parse_source(&sources[i]);
+
+        // The subpages of a page follow each other, and only the first one is stored
+        if (page && page->id >= start && page->id <= end && page->id != last_id) {
+            last_id = page->id;
+
+            if (store_put(store, page->id, sources[i].data, sources[i].size)) {
+                pages->pages[stored++] = page;
+                continue;
+            }
+        }
+
+        page_destroy(page);
+    }
+
+    if (pages) {
+        pages->size = stored;
+    } else {
+        error_set(TTT_ERROR_OUT_OF_MEMORY);
+    }
+
+    free(sources);
+    return pages;
+}
+
+page_t *store_get_page(page_store_t *store, uint16_t id, time_t *stored_at) {
+    char path[PATH_MAX];
+    struct stat info;
+
+    if (!store || !get_file_path(store, id, "", path, PATH_MAX)) {
+        return NULL;
+    }
+
+    FILE *file = fopen(path, "r");
+
+    if (!file) {
+        // Pages that have not been stored are not an error
+        return NULL;
+    }
+
+    char *data = NULL;
+    size_t size = 0;
+
+    if (fstat(fileno(file), &info) == 0 && info.st_size > 0) {
+        size = info.st_size;
+        data = malloc(size + 1);
+    }
+
+    if (!data || fread(data, 1, size, file) != size) {
+        fclose(file);
+        free(data);
+        error_set(TTT_ERROR_STORE_FAILED);
+        return NULL;
+    }
+
+    fclose(file);
+    data[size] = '\0';
+    page_t *page = parser_get_page(data, size);
+    free(data);
+
+    if (page && stored_at) {
+        *stored_at = info.st_mtime;
+    }
+
+    return page;
+}
+
+bool store_contains(page_store_t *store, uint16_t id) {
+    char path[PATH_MAX];
+    return store && get_file_path(store, id, "", path, PATH_MAX) && access(path, R_OK) == 0;
+}
+
+void store_remove(page_store_t *store, uint16_t id) {
+    char path[PATH_MAX];
+
+    if (store && get_file_path(store, id, "", path, PATH_MAX)) {
+        remove(path);
+    }
+}
+
+static bool get_last_page_path(page_store_t *store, char *buf, size_t buf_size) {
+    int length = snprintf(buf, buf_size, "%s/%s", store->path, STORE_LAST_PAGE_FILE_NAME);
+    return length > 0 && (size_t)length < buf_size;
+}
+
+/// @return the page that was shown when the user quit last time, or 0 if it is not known
+uint16_t store_get_last_page(page_store_t *store) {
+    char path[PATH_MAX];
+    unsigned int id = 0;
+
+    if (!store || !get_last_page_path(store, path, PATH_MAX)) {
+        return 0;
+    }
+
+    FILE *file = fopen(path, "r");
+
+    if (!file) {
+        return 0;
+    }
+
+    if (fscanf(file, "%u", &id) != 1 || id > UINT16_MAX) {
+        id = 0;
+    }
+
+    fclose(file);
+    return id;
+}
+
+/// @brief Remembers the page that is shown, so that it can be shown first the next time
+bool store_set_last_page(page_store_t *store, uint16_t id) {
+    char path[PATH_MAX];
+
+    if (!store || !get_last_page_path(store, path, PATH_MAX)) {
+        return false;
+    }
+
+    FILE *file = fopen(path, "w");
+
+    if (!file) {
+        error_set(TTT_ERROR_STORE_FAILED);
+        return false;
+    }
+
+    bool written = fprintf(file, "%d\n", id) > 0;
+
+    if (fclose(file) != 0 || !written) {
+        error_set(TTT_ERROR_STORE_FAILED);
+        return false;
+    }
+
+    return true;
+}
+
+/// @brief The directory of the store, where other files that are kept between runs can go
+const char *store_get_path(page_store_t *store) {
+    return store->path;
+}
+
+void store_close(page_store_t *store) {
+    free(store);
+}
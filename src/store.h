@@ -0,0 +1,32 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "pages.h"
+#include "parser.h"
+#include "errors.h"
+
+#define STORE_DIR_NAME "ttt"
+#define STORE_LAST_PAGE_FILE_NAME "last_page"
+#define STORE_MAX_SUBPAGES 8
+
+typedef struct page_store page_store_t;
+
+page_store_t *store_open(const char *path);
+bool store_put(page_store_t *store, uint16_t id, const char *source, size_t size);
+page_collection_t *store_put_range(page_store_t *store, uint16_t start, uint16_t end, const char *data, size_t size);
+page_t *store_get_page(page_store_t *store, uint16_t id, time_t *stored_at);
+bool store_contains(page_store_t *store, uint16_t id);
+void store_remove(page_store_t *store, uint16_t id);
+const char *store_get_path(page_store_t *store);
+uint16_t store_get_last_page(page_store_t *store);
+bool store_set_last_page(page_store_t *store, uint16_t id);
+void store_close(page_store_t *store);
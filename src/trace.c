@@ -0,0 +1,195 @@
+#include "trace.h"
+
+#define EVENT_BUF_SIZE  512
+#define BUFFER_SIZE     65536
+
+// Only set before any other threads are started, so it can be read without a lock
+static bool enabled = false;
+static int fd = -1;
+static bool first_event = true;
+// The events are collected here and written by whichever thread fills it
+static char buffer[BUFFER_SIZE];
+static size_t buffer_size = 0;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local long thread_id = 0;
+static _Thread_local uint64_t thread_bytes_written = 0;
+
+static long get_thread_id() {
+    if (!thread_id) {
+        thread_id = syscall(SYS_gettid);
+    }
+
+    return thread_id;
+}
+
+/// @brief Writes the buffered events to the file, must be called with the lock held
+static void flush_buffer() {
+    size_t written = 0;
+
+    while (written < buffer_size) {
+        ssize_t result = write(fd, buffer + written, buffer_size - written);
+
+        if (result < 0 && errno == EINTR) {
+            continue;
+        } else if (result < 0) {
+            // The rest of the trace is lost, but the program keeps going
+            break;
+        }
+
+        written += result;
+    }
+
+    thread_bytes_written += written;
+    buffer_size = 0;
+}
+
+static void append(const char *str, size_t size) {
+    if (buffer_size + size > BUFFER_SIZE) {
+        flush_buffer();
+    }
+
+    memcpy(buffer + buffer_size, str, size);
+    buffer_size += size;
+}
+
+/// @brief Writes an event in the Chrome trace event format, which Perfetto can also open.
+///        The names are always string literals, so they never have to be escaped.
+static void write_event(const char *format, ...) {
+    char event[EVENT_BUF_SIZE];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(event + 2, EVENT_BUF_SIZE - 2, format, args);
+    va_end(args);
+
+    if (length < 0 || length >= EVENT_BUF_SIZE - 2) {
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+    // Every event is on its own line, after the separator of the previous one
+    event[0] = first_event ? ' ' : ',';
+    event[1] = '\n';
+    append(event, length + 2);
+    first_event = false;
+    pthread_mutex_unlock(&lock);
+}
+
+static void write_span_event(char phase, const char *name, uint16_t page_id) {
+    write_event(
+        "{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%" PRIu64 ",\"pid\":%d,\"tid\":%ld,\"args\":{\"page\":%u}}",
+        name,
+        phase,
+        trace_get_time_us(),
+        getpid(),
+        get_thread_id(),
+        page_id
+    );
+}
+
+/// @brief Starts tracing if TTT_TRACE is set, once before any other threads are started
+/// @return false if the trace file could not be opened
+bool trace_initialize() {
+    const char *path = getenv(TRACE_ENV_VARIABLE);
+
+    if (!path || !*path) {
+        return true;
+    }
+
+    if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) == -1) {
+        return false;
+    }
+
+    // The closing bracket is optional in the array format, so a trace of a crash can be read
+    append("[", 1);
+    enabled = true;
+    trace_set_thread_name("main");
+    return true;
+}
+
+/// @brief Whether anything is traced, to skip collecting what would only be traced
+bool trace_is_enabled() {
+    return enabled;
+}
+
+uint64_t trace_get_time_us() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/// @brief Names the calling thread in the trace
+void trace_set_thread_name(const char *name) {
+    if (!enabled) {
+        return;
+    }
+
+    write_event(
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%ld,\"args\":{\"name\":\"%s\"}}",
+        getpid(),
+        get_thread_id(),
+        name
+    );
+}
+
+/// @brief Starts a span on the calling thread, which is ended by 'trace_end()'
+void trace_begin(const char *name, uint16_t page_id) {
+    if (enabled) {
+        write_span_event('B', name, page_id);
+    }
+}
+
+void trace_end(const char *name, uint16_t page_id) {
+    if (enabled) {
+        write_span_event('E', name, page_id);
+    }
+}
+
+/// @brief Adds a span that has already ended, e.g. with the times that curl measured
+void trace_complete(const char *name, uint16_t page_id, uint64_t start_us, uint64_t duration_us) {
+    if (!enabled) {
+        return;
+    }
+
+    write_event(
+        "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%" PRIu64 ",\"dur\":%" PRIu64 ",\"pid\":%d,\"tid\":%ld,\"args\":{\"page\":%u}}",
+        name,
+        start_us,
+        duration_us,
+        getpid(),
+        get_thread_id(),
+        page_id
+    );
+}
+
+void trace_counter(const char *name, int64_t value) {
+    if (!enabled) {
+        return;
+    }
+
+    write_event(
+        "{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%" PRIu64 ",\"pid\":%d,\"args\":{\"value\":%" PRId64 "}}",
+        name,
+        trace_get_time_us(),
+        getpid(),
+        value
+    );
+}
+
+/// @brief Finishes the trace, after every other thread has stopped
+void trace_destroy() {
+    if (!enabled) {
+        return;
+    }
+
+    enabled = false;
+    append("\n]\n", 3);
+    flush_buffer();
+    close(fd);
+    fd = -1;
+}
+
+/// @brief Returns the bytes that the calling thread has written to the trace file, so that
+///        they can be told apart from the other writes of the thread, see 'output.c'
+uint64_t trace_get_thread_bytes_written() {
+    return thread_bytes_written;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/syscall.h>
+
+// The file that the trace is written to, e.g. TTT_TRACE=trace.json
+#define TRACE_ENV_VARIABLE "TTT_TRACE"
+
+bool trace_initialize();
+bool trace_is_enabled();
+uint64_t trace_get_time_us();
+void trace_set_thread_name(const char *name);
+void trace_begin(const char *name, uint16_t page_id);
+void trace_end(const char *name, uint16_t page_id);
+void trace_complete(const char *name, uint16_t page_id, uint64_t start_us, uint64_t duration_us);
+void trace_counter(const char *name, int64_t value);
+uint64_t trace_get_thread_bytes_written();
+void trace_destroy();
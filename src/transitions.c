@@ -0,0 +1,215 @@
+#include "transitions.h"
+
+#define FILE_MAGIC          "TTTM"
+#define FILE_MAGIC_LENGTH   4
+#define FILE_VERSION        1
+// The counts of a page are halved when one of them reaches this, so that old habits fade out
+#define MAX_COUNT           1024
+
+typedef struct transition {
+    uint16_t to;
+    uint16_t count;
+} transition_t;
+
+typedef struct page_transitions {
+    transition_t next[TRANSITIONS_PER_PAGE];    // the most common first, unused ones have no count
+    uint32_t total;             // every transition from the page, including the forgotten ones
+} page_transitions_t;
+
+// A first-order Markov model of how the user moves between pages. Only the most
+// common next pages are kept for each page, and the least common one is replaced
+// by a page that has not been seen before. The model has a fixed size, and is saved
+// to disk as it is kept in memory.
+struct transition_model {
+    page_transitions_t pages[TRANSITIONS_MAX_PAGE_ID + 1];
+};
+
+static void halve_counts(page_transitions_t *page) {
+    for (int i = 0; i < TRANSITIONS_PER_PAGE; i++) {
+        page->next[i].count /= 2;
+    }
+
+    page->total /= 2;
+}
+
+static bool is_valid_page(const page_transitions_t *page) {
+    uint32_t sum = 0;
+
+    for (int i = 0; i < TRANSITIONS_PER_PAGE; i++) {
+        if (page->next[i].to > TRANSITIONS_MAX_PAGE_ID) {
+            return false;
+        }
+
+        if (i > 0 && page->next[i].count > page->next[i - 1].count) {
+            return false;
+        }
+
+        sum += page->next[i].count;
+    }
+
+    return sum <= page->total;
+}
+
+transition_model_t *transitions_create() {
+    transition_model_t *model = calloc(1, sizeof(transition_model_t));
+
+    if (!model) {
+        error_set(TTT_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    return model;
+}
+
+/// @brief Remembers that the user went from one page to another
+void transitions_record(transition_model_t *model, uint16_t from, uint16_t to) {
+    if (from > TRANSITIONS_MAX_PAGE_ID || to > TRANSITIONS_MAX_PAGE_ID || from == to) {
+        return;
+    }
+
+    page_transitions_t *page = &model->pages[from];
+    int i = 0;
+
+    while (i < TRANSITIONS_PER_PAGE - 1 && page->next[i].count > 0 && page->next[i].to != to) {
+        i++;
+    }
+
+    // The least common page is replaced if every one is used
+    if (page->next[i].to != to || page->next[i].count == 0) {
+        page->next[i].to = to;
+        page->next[i].count = 0;
+    }
+
+    page->next[i].count++;
+    page->total++;
+
+    while (i > 0 && page->next[i].count > page->next[i - 1].count) {
+        transition_t previous = page->next[i - 1];
+        page->next[i - 1] = page->next[i];
+        page->next[i] = previous;
+        i--;
+    }
+
+    if (page->next[i].count >= MAX_COUNT) {
+        halve_counts(page);
+    }
+}
+
+/// @brief Gets the pages that the user will most likely go to next, the most likely first
+/// @param min_probability the share of the transitions from the page that a page needs
+/// @return the number of pages that were written to 'ids'
+size_t transitions_predict(
+    transition_model_t *model,
+    uint16_t from,
+    uint16_t *ids,
+    size_t max_ids,
+    double min_probability
+) {
+    if (from > TRANSITIONS_MAX_PAGE_ID) {
+        return 0;
+    }
+
+    page_transitions_t *page = &model->pages[from];
+    size_t count = 0;
+
+    for (int i = 0; i < TRANSITIONS_PER_PAGE && count < max_ids; i++) {
+        if (page->next[i].count == 0 || (double)page->next[i].count / page->total < min_probability) {
+            break;
+        }
+
+        ids[count] = page->next[i].to;
+        count++;
+    }
+
+    return count;
+}
+
+/// @return the number of transitions from a page that have been recorded
+uint32_t transitions_get_count(transition_model_t *model, uint16_t from) {
+    return from <= TRANSITIONS_MAX_PAGE_ID ? model->pages[from].total : 0;
+}
+
+/// @brief Replaces the model with one that has been saved, a missing file is not an error
+/// @return false if the file could not be read, in which case the model is empty
+bool transitions_load(transition_model_t *model, const char *path) {
+    FILE *file = fopen(path, "rb");
+
+    if (!file) {
+        return true;
+    }
+
+    char magic[FILE_MAGIC_LENGTH];
+    uint16_t version;
+    uint16_t id;
+    page_transitions_t page;
+    memset(model, 0, sizeof(transition_model_t));
+
+    bool valid = (
+        fread(magic, 1, FILE_MAGIC_LENGTH, file) == FILE_MAGIC_LENGTH &&
+        memcmp(magic, FILE_MAGIC, FILE_MAGIC_LENGTH) == 0 &&
+        fread(&version, sizeof(version), 1, file) == 1 &&
+        version == FILE_VERSION
+    );
+
+    // The pages that have transitions follow the header, each after its id
+    while (valid && fread(&id, sizeof(id), 1, file) == 1) {
+        valid = id <= TRANSITIONS_MAX_PAGE_ID && fread(&page, sizeof(page), 1, file) == 1 && is_valid_page(&page);
+
+        if (valid) {
+            model->pages[id] = page;
+        }
+    }
+
+    fclose(file);
+
+    if (!valid) {
+        memset(model, 0, sizeof(transition_model_t));
+        error_set(TTT_ERROR_STORE_FAILED);
+    }
+
+    return valid;
+}
+
+/// @brief Saves the model, replacing the file in one step like the stored pages
+bool transitions_save(transition_model_t *model, const char *path) {
+    char temporary_path[PATH_MAX];
+    int length = snprintf(temporary_path, PATH_MAX, "%s.tmp", path);
+
+    if (length <= 0 || length >= PATH_MAX) {
+        error_set(TTT_ERROR_STORE_FAILED);
+        return false;
+    }
+
+    FILE *file = fopen(temporary_path, "wb");
+
+    if (!file) {
+        error_set(TTT_ERROR_STORE_FAILED);
+        return false;
+    }
+
+    uint16_t version = FILE_VERSION;
+    bool written = (
+        fwrite(FILE_MAGIC, 1, FILE_MAGIC_LENGTH, file) == FILE_MAGIC_LENGTH &&
+        fwrite(&version, sizeof(version), 1, file) == 1
+    );
+
+    for (uint16_t id = 0; id <= TRANSITIONS_MAX_PAGE_ID && written; id++) {
+        if (model->pages[id].total > 0) {
+            written = fwrite(&id, sizeof(id), 1, file) == 1 && fwrite(&model->pages[id], sizeof(page_transitions_t), 1, file) == 1;
+        }
+    }
+
+    written = fclose(file) == 0 && written;
+
+    if (!written || rename(temporary_path, path) != 0) {
+        remove(temporary_path);
+        error_set(TTT_ERROR_STORE_FAILED);
+        return false;
+    }
+
+    return true;
+}
+
+void transitions_destroy(transition_model_t *model) {
+    free(model);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+
+#include "errors.h"
+
+// Every page id that can be navigated from or to, see CACHE_MAX_PAGE_ID
+#define TRANSITIONS_MAX_PAGE_ID     999
+// The most common next pages that are remembered for each page
+#define TRANSITIONS_PER_PAGE        8
+#define TRANSITIONS_FILE_NAME       "transitions"
+
+typedef struct transition_model transition_model_t;
+
+transition_model_t *transitions_create();
+void transitions_record(transition_model_t *model, uint16_t from, uint16_t to);
+size_t transitions_predict(
+    transition_model_t *model,
+    uint16_t from,
+    uint16_t *ids,
+    size_t max_ids,
+    double min_probability
+);
+uint32_t transitions_get_count(transition_model_t *model, uint16_t from);
+bool transitions_load(transition_model_t *model, const char *path);
+bool transitions_save(transition_model_t *model, const char *path);
+void transitions_destroy(transition_model_t *model);
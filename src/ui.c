@@ -1,6 +1,7 @@
 #include "ui.h"
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 
 #define LOWERCASE_QUIT      "q"
 #define QUIT                "Q"
@@ -8,87 +9,784 @@
 #define DELETE              127
 #define BACKSPACE           8
 #define PAGE_ID_MAX_LENGTH  3
+#define LINK_COMMAND_PREFIX '#'
+#define BYTES_COMMAND       "bytes"
+#define MESSAGE_BUF_SIZE    64
+#define COMMAND_BUF_SIZE    256
+#define ESCAPE_DELAY_MS     25
+#define RESIZE_DELAY_MS     50
+#define NAVIGATION_DELAY_MS 150
+#define PREFETCH_DELAY_MS   1
+#define PREFETCH_QUEUE_SIZE 8
+#define PAGE_CACHE_CAPACITY 256
+#define SPECULATION_DELAY_MS 1
+#define HISTORY_CAPACITY    32
+#define LIVE_INTERVAL_MS    30000
+#define SEARCH_COMMAND_PREFIX '/'
+#define MAX_SEARCH_HITS     32
+#define INDEX_FIRST_PAGE    100
+#define INDEX_LAST_PAGE     899
+#define INDEX_RANGE_SIZE    20
+#define INDEX_DELAY_MS      10
+#define CRAWL_COMMAND       "crawl"
+#define STATS_COMMAND       "stats"
+// The pages that the user usually goes to next are prefetched, if they are likely enough
+#define PREDICTED_PAGE_COUNT 3
+#define PREDICTION_MIN_PROBABILITY 0.25
+// Stored pages are shown instead of fetching them again for a while, e.g. after a crawl
+#define STORED_PAGE_MAX_AGE 600
+#define WORKER_COUNT        4
 
-// TODO: Add window buffer cache to prevent rerendering of pages when switching between VIEW_MAIN and VIEW_HELP
 // TODO: Add window where we will echo and take input
 static WINDOW *content_win;
 static WINDOW *command_win;
-static int current_page_index = -1;
-static int previous_page_index = -1;
-static int previous_page_link_index = -1;
 static int current_page_id = TTT_PAGE_HOME;
 static page_t *current_page = NULL;
-static page_collection_t *collection;
+static page_cache_t *cache = NULL;
+static history_t *history = NULL;
+static int live_timer = EVENTS_INVALID_SOURCE;
+static bool live_pages[CACHE_MAX_PAGE_ID + 1];
+static search_index_t *search_index = NULL;
+static int index_timer = EVENTS_INVALID_SOURCE;
+static uint16_t next_index_id = INDEX_FIRST_PAGE;
+static search_hit_t search_hits[MAX_SEARCH_HITS];
+static size_t search_hit_count = 0;
+static size_t search_hit_position = 0;
+static char search_query_buf[COMMAND_BUF_SIZE];
+static page_store_t *store = NULL;
+static bool drop_frames = false;
+static int resize_timer = EVENTS_INVALID_SOURCE;
+static int navigation_timer = EVENTS_INVALID_SOURCE;
+static uint16_t navigation_target = 0;
+static uint64_t last_navigation_ms = 0;
+static int prefetch_timer = EVENTS_INVALID_SOURCE;
+static uint16_t prefetch_queue[PREFETCH_QUEUE_SIZE];
+static bool prefetch_predicted[PREFETCH_QUEUE_SIZE];
+static int prefetch_count = 0;
+static transition_model_t *transitions = NULL;
+static char transitions_path[PATH_MAX];
+// The cached pages that were fetched since they were predicted, until they are shown
+static bool predicted_pages[CACHE_MAX_PAGE_ID + 1];
+static unsigned int predicted_fetch_count = 0;
+static unsigned int prediction_hit_count = 0;
+// Cached pages that have not been added to the search index yet, see 'index_cached_pages()'
+static bool unindexed_pages[CACHE_MAX_PAGE_ID + 1];
+// When the steps of starting were done, for '--timing'
+static uint64_t startup_ms = 0;
+static uint64_t terminal_ready_ms = 0;
+static uint64_t first_page_ms = 0;
+static uint64_t first_paint_ms = 0;
+static int speculation_timer = EVENTS_INVALID_SOURCE;
+static uint16_t speculated_start = 0;
+static uint16_t speculated_end = 0;
+static worker_job_t *speculation_job = NULL;
+// The pages that are being fetched by the workers
+static worker_job_t *page_jobs[CACHE_MAX_PAGE_ID + 1];
+// The jobs of 'page_jobs' that prefetch a page since it was predicted, see 'handle_fetched_page()'
+static worker_job_t *predicted_jobs[CACHE_MAX_PAGE_ID + 1];
+static worker_job_t *live_job = NULL;
+static worker_job_t *index_job = NULL;
+static worker_job_t *tokenize_job = NULL;
+// A search that waits for the cached pages to be indexed
+static bool search_pending = false;
+static bool command_mode = false;
+static int command_buf_length = 0;
+static char command_buf[COMMAND_BUF_SIZE];
 
-static void set_page_index(int index) {
-    if (!collection || index == -1 || collection->size <= index) {
+static uint64_t get_time_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static bool is_valid_page_id(uint16_t id) {
+    return id >= TTT_PAGE_HOME && id <= CACHE_MAX_PAGE_ID;
+}
+
+/// @brief Prefetches a page when there is nothing else to do
+/// @param predicted if the page is only prefetched since the user usually goes to it
+static void prefetch(uint16_t id, bool predicted) {
+    if (!is_valid_page_id(id) || cache_contains(cache, id) || prefetch_count == PREFETCH_QUEUE_SIZE) {
         return;
     }
 
-    previous_page_index = current_page_index;
-    previous_page_link_index = draw_get_highlighted_link_index();
-    current_page_index = index;
-    current_page = collection->pages[index];
-    current_page_id = current_page->id;
+    for (int i = 0; i < prefetch_count; i++) {
+        if (prefetch_queue[i] == id) {
+            return;
+        }
+    }
+
+    prefetch_queue[prefetch_count] = id;
+    prefetch_predicted[prefetch_count] = predicted;
+    prefetch_count++;
+    events_set_timer(prefetch_timer, PREFETCH_DELAY_MS, 0);
+}
+
+/// @brief Adds a page that has been fetched to the cache and the search index
+/// @return false if the page could not be cached, in which case it is destroyed
+static bool store_page(page_t *page) {
+    if (!cache_put(cache, page)) {
+        page_destroy(page);
+        return false;
+    }
+
+    trace_counter("cached_pages", cache_get_size(cache));
+
+    // Pages that have been parsed by a worker are indexed right away. The rest are only
+    // parsed and indexed once something is searched for, since most are never shown.
+    if (page_is_tokenized(page)) {
+        unindexed_pages[page->id] = false;
+        search_add_page(search_index, page);
+    } else {
+        unindexed_pages[page->id] = true;
+    }
+
+    return true;
+}
+
+/// @brief Remembers the highlighted link and the rendered frame of the current
+///        page, so that it can be shown again as it was when going back to it
+static void save_history_state() {
+    if (history_get_current(history)) {
+        history_set_state(history, draw_get_highlighted_link_index(), draw_copy_frame());
+    }
+}
+
+/// @brief Sets the page that the user is waiting for. The request of the previous
+///        page is cancelled, since the user has moved on from it.
+static void set_navigation_target(uint16_t id) {
+    if (navigation_target && navigation_target != id && page_jobs[navigation_target]) {
+        workers_cancel(page_jobs[navigation_target]);
+    }
+
+    navigation_target = id;
+}
+
+static void set_current_page(page_t *page) {
+    // A page that was waiting to be fetched is no longer wanted
+    set_navigation_target(0);
+    events_set_timer(navigation_timer, 0, 0);
+    current_page = page;
+    current_page_id = page->id;
+
+    // Check for updates right away, since the cached page might be old
+    if (live_pages[page->id]) {
+        events_set_timer(live_timer, 1, LIVE_INTERVAL_MS);
+    } else {
+        events_set_timer(live_timer, 0, 0);
+    }
+
+    // Make the next and previous page instant, instead of the ones around the page before
+    workers_cancel_waiting(SCHEDULER_PRIORITY_PREFETCH);
+    prefetch_count = 0;
+    prefetch(page->next_id, false);
+    prefetch(page->prev_id, false);
+
+    // And the pages that the user usually goes to from this one
+    uint16_t predicted[PREDICTED_PAGE_COUNT];
+    size_t predicted_count = 0;
+
+    if (transitions) {
+        predicted_count = transitions_predict(
+            transitions,
+            page->id,
+            predicted,
+            PREDICTED_PAGE_COUNT,
+            PREDICTION_MIN_PROBABILITY
+        );
+    }
+
+    for (size_t i = 0; i < predicted_count; i++) {
+        prefetch(predicted[i], true);
+    }
+}
+
+static void show_page(page_t *page) {
+    if (page != current_page) {
+        // Learn where the user goes from the previous page, see 'set_current_page()'
+        if (transitions && current_page) {
+            transitions_record(transitions, current_page->id, page->id);
+        }
+
+        // The pages in the history are pinned so that they are never evicted
+        save_history_state();
+        history_push(history, page);
+
+        // Going back in the history does not count, the page was already shown
+        if (predicted_pages[page->id]) {
+            predicted_pages[page->id] = false;
+            prediction_hit_count++;
+        }
+    }
+
+    set_current_page(page);
     draw(content_win, VIEW_MAIN, current_page);
+
+    if (!first_paint_ms) {
+        first_paint_ms = get_time_ms();
+    }
+}
+
+/// @brief Shows a page from the history as it was left, without rendering it again
+static void show_history_entry(history_entry_t *entry) {
+    set_current_page(entry->page);
+    draw_restore(content_win, entry->page, entry->frame, entry->link_index);
+}
+
+/// @brief Caches a page that has been fetched, and shows it if the user is waiting for it
+static void handle_fetched_page(worker_job_t *job) {
+    uint16_t id = job->start;
+    page_t *page = job->page;
+    bool superseded = page_jobs[id] != job;
+    bool predicted_job = predicted_jobs[id] == job;
+    // The page is owned by the cache
+    job->page = NULL;
+    error_reset();
+
+    if (predicted_job) {
+        predicted_jobs[id] = NULL;
+    }
+
+    if (!superseded) {
+        page_jobs[id] = NULL;
+    }
+
+    if (page) {
+        // Pages that do not exist have no id, cache them as empty pages
+        if (!is_valid_page_id(page->id)) {
+            page->id = id;
+        }
+
+        if (!store_page(page)) {
+            page = NULL;
+        }
+    }
+
+    if (page) {
+        // A prediction was only useful if it was fetched before the user asked for the page
+        bool predicted = predicted_job && job->entry.priority == SCHEDULER_PRIORITY_PREFETCH;
+
+        if (predicted && !predicted_pages[id]) {
+            predicted_fetch_count++;
+        }
+
+        predicted_pages[id] = predicted;
+    }
+
+    // A cancelled job might have been replaced by a new one for the same page
+    if (id != navigation_target || (!page && superseded)) {
+        return;
+    }
+
+    navigation_target = 0;
+
+    if (!page) {
+        // Cancelled requests are of pages that the user has moved on from
+        if (job->error.code != TTT_ERROR_REQUEST_CANCELLED) {
+            draw_error(error_get_context_string(&job->error));
+        }
+
+        return;
+    }
+
+    if (!first_paint_ms) {
+        first_page_ms = job->completed_ms;
+    }
+
+    show_page(page);
+
+    if (job->offline) {
+        char message[MESSAGE_BUF_SIZE];
+        strftime(message, MESSAGE_BUF_SIZE, "Offline, showing the page from %Y-%m-%d %H:%M", localtime(&job->stored_at));
+        // Shown like an error, but the page is shown
+        draw_error(message);
+    }
+}
+
+/// @brief Starts fetching a page in the background, unless it is already being fetched.
+///        Recently stored pages are used instead of fetching them, and any stored page
+///        if the request fails.
+/// @param priority raises the priority of the page if it is already being fetched
+/// @return the job that fetches the page, or NULL if it could not be created
+static worker_job_t *fetch_page(uint16_t id, scheduler_priority_t priority) {
+    if (page_jobs[id] && !workers_is_cancelled(page_jobs[id])) {
+        workers_promote(page_jobs[id], priority);
+        return page_jobs[id];
+    }
+
+    worker_job_t *job = workers_create_job(WORKER_JOB_PAGE, id, 0, handle_fetched_page, NULL);
+
+    if (!job) {
+        return NULL;
+    }
+
+    job->store = store;
+    job->max_stored_age = STORED_PAGE_MAX_AGE;
+    page_jobs[id] = job;
+    workers_submit(job, priority);
+    return job;
 }
 
 static void set_page(uint16_t id) {
     error_reset();
 
     // Check if the page has been cached
-    for (int i = 0; i < collection->size; i++) {
-        if (collection->pages[i]->id == id) {
-            // TODO: Refetch page if it has an update (and some time has passed, e.g. 5 min)
-            set_page_index(i);
-            return;
+    // TODO: Refetch page if it has an update (and some time has passed, e.g. 5 min)
+    page_t *page = cache_get(cache, id);
+
+    if (page) {
+        show_page(page);
+        return;
+    }
+
+    // The page is shown once it has been fetched
+    set_navigation_target(id);
+
+    // Wait for the pages that are fetched while the page number is typed, if it is one of them
+    if (speculation_job && id >= speculated_start && id <= speculated_end) {
+        workers_promote(speculation_job, SCHEDULER_PRIORITY_VISIBLE);
+        return;
+    }
+
+    fetch_page(id, SCHEDULER_PRIORITY_VISIBLE);
+}
+
+/// @brief Shows a page once the user has stopped navigating, so that only the
+///        last page is fetched when e.g. the next page key is held down
+static void navigate_to(uint16_t id) {
+    uint64_t now = get_time_ms();
+    bool navigating = now - last_navigation_ms < NAVIGATION_DELAY_MS;
+    last_navigation_ms = now;
+    current_page_id = id;
+
+    // Cached pages are cheap to show
+    if (cache_contains(cache, id)) {
+        set_page(id);
+        return;
+    }
+
+    // The short delay lets any keys that have already been typed be handled first
+    set_navigation_target(id);
+    events_set_timer(navigation_timer, navigating ? NAVIGATION_DELAY_MS : 1, 0);
+}
+
+static void handle_navigation_timeout(void *data) {
+    uint16_t id = navigation_target;
+    navigation_target = 0;
+
+    if (id) {
+        set_page(id);
+    }
+}
+
+static void handle_prefetch_timeout(void *data) {
+    // The page that the user is waiting for goes first,
+    // the queue is filled again once it has been shown
+    if (navigation_target) {
+        return;
+    }
+
+    for (int i = 0; i < prefetch_count; i++) {
+        uint16_t id = prefetch_queue[i];
+
+        if (cache_contains(cache, id)) {
+            continue;
+        }
+
+        worker_job_t *job = fetch_page(id, SCHEDULER_PRIORITY_PREFETCH);
+
+        // Counted once the page has been fetched, since the job is cancelled
+        // if the user moves on first, see 'handle_fetched_page()'
+        if (job && prefetch_predicted[i]) {
+            predicted_jobs[id] = job;
         }
     }
 
-    page_t *page = api_get_page(id);
+    prefetch_count = 0;
+}
+
+/// @brief Shows the new version of the current page if it has been updated,
+///        only redrawing the rows that have changed
+static void handle_live_update(worker_job_t *job) {
+    page_t *page = current_page;
+    page_t *update = job->page;
+    live_job = NULL;
 
-    if (!page) {
-        if (error_is_set()) {
-            draw_error(error_get_string());
+    // Not modified, or the request failed, which is tried again next time.
+    // The user might also have moved on while the page was being fetched.
+    if (!update || !page || update->id != page->id || !live_pages[page->id] || navigation_target) {
+        return;
+    }
+
+    // The server does not have to support conditional requests
+    if (update->unix_date == page->unix_date) {
+        return;
+    }
+
+    // The page is owned by the cache
+    job->page = NULL;
+    error_reset();
+
+    if (!store_page(update)) {
+        return;
+    }
+
+    // The old page is pinned by the history until it has been replaced
+    draw_update(content_win, page, update);
+    history_replace_current(history, update);
+    current_page = update;
+}
+
+/// @brief Checks if the current page has been updated
+static void handle_live_timeout(void *data) {
+    page_t *page = current_page;
+
+    if (!page || !live_pages[page->id] || navigation_target || live_job) {
+        return;
+    }
+
+    live_job = workers_create_job(WORKER_JOB_PAGE_UPDATE, page->id, 0, handle_live_update, NULL);
+
+    if (live_job) {
+        live_job->modified_since = page->unix_date;
+        atomic_store(&live_job->tokenize, true);
+        workers_submit(live_job, SCHEDULER_PRIORITY_REVALIDATE);
+    }
+}
+
+static void toggle_live_mode() {
+    if (draw_get_current_view() != VIEW_MAIN || !current_page) {
+        return;
+    }
+
+    bool live = !live_pages[current_page->id];
+    live_pages[current_page->id] = live;
+    events_set_timer(live_timer, live ? 1 : 0, live ? LIVE_INTERVAL_MS : 0);
+    draw_command_message(command_win, live ? "Live updates on" : "Live updates off");
+}
+
+static bool is_indexing() {
+    return next_index_id <= INDEX_LAST_PAGE;
+}
+
+static void handle_indexed_pages(worker_job_t *job) {
+    page_collection_t *pages = job->pages;
+    index_job = NULL;
+
+    // Try again with the next search if the request failed
+    if (!pages) {
+        return;
+    }
+
+    for (size_t i = 0; i < pages->size; i++) {
+        // Pages that have been fetched before are already indexed, and might be newer
+        uint16_t id = pages->pages[i]->id;
+
+        if (id <= CACHE_MAX_PAGE_ID && !search_contains_page(search_index, id)) {
+            unindexed_pages[id] = false;
+            search_add_page(search_index, pages->pages[i]);
+        }
+    }
+
+    // Pages that can not be parsed are not shown, so neither are their errors
+    error_reset();
+
+    next_index_id = job->end + 1;
+
+    if (is_indexing()) {
+        events_set_timer(index_timer, INDEX_DELAY_MS, 0);
+    }
+}
+
+/// @brief Indexes the pages that have not been visited for searching, a range at a time
+///        whenever there is nothing else to fetch. The pages are not cached.
+static void handle_index_timeout(void *data) {
+    // Pages that the user is waiting for, or will probably want next, go first
+    if (navigation_target || prefetch_count > 0) {
+        events_set_timer(index_timer, NAVIGATION_DELAY_MS, 0);
+        return;
+    }
+
+    if (index_job || !is_indexing()) {
+        return;
+    }
+
+    uint16_t end = next_index_id + INDEX_RANGE_SIZE - 1;
+
+    if (end > INDEX_LAST_PAGE) {
+        end = INDEX_LAST_PAGE;
+    }
+
+    index_job = workers_create_job(WORKER_JOB_PAGE_RANGE, next_index_id, end, handle_indexed_pages, NULL);
+
+    if (index_job) {
+        atomic_store(&index_job->tokenize, true);
+        workers_submit(index_job, SCHEDULER_PRIORITY_CRAWL);
+    }
+}
+
+static void show_search_hit() {
+    uint16_t id = search_hits[search_hit_position].page_id;
+    char message[MESSAGE_BUF_SIZE];
+    int length = snprintf(message, MESSAGE_BUF_SIZE, "%zu/%zu:", search_hit_position + 1, search_hit_count);
+
+    // List the following hits, as many as fit on the command line
+    for (size_t i = 1; i < search_hit_count && length + 4 < PAGE_COLS - 1; i++) {
+        size_t hit = (search_hit_position + i) % search_hit_count;
+        length += snprintf(message + length, MESSAGE_BUF_SIZE - length, " %d", search_hits[hit].page_id);
+    }
+
+    // Cached pages are drawn right away, with the words of this query highlighted
+    draw_set_search_highlight(id, search_query_buf);
+    navigate_to(id);
+    draw_command_message(command_win, message);
+}
+
+/// @brief Searches for the last query and shows the first hit
+static void run_search() {
+    search_hit_count = search_query(search_index, search_query_buf, search_hits, MAX_SEARCH_HITS);
+    search_hit_position = 0;
+
+    if (search_hit_count > 0) {
+        show_search_hit();
+        return;
+    }
+
+    char message[MESSAGE_BUF_SIZE];
+
+    if (is_indexing()) {
+        int progress = (next_index_id - INDEX_FIRST_PAGE) * 100 / (INDEX_LAST_PAGE - INDEX_FIRST_PAGE + 1);
+        snprintf(message, MESSAGE_BUF_SIZE, "No hits yet, indexing pages (%d%%)", progress);
+    } else {
+        snprintf(message, MESSAGE_BUF_SIZE, "No hits");
+    }
+
+    draw_command_message(command_win, message);
+}
+
+static void handle_tokenized_pages(worker_job_t *job) {
+    page_collection_t *pages = job->pages;
+    tokenize_job = NULL;
+
+    for (size_t i = 0; i < pages->size; i++) {
+        page_t *page = cache_peek(cache, pages->pages[i]->id);
+
+        // The page might have been replaced while it was parsed, then it is parsed again
+        if (!page || page->serial != pages->pages[i]->serial) {
+            continue;
+        }
+
+        page_move_tokens(page, pages->pages[i]);
+
+        // Pages that can not be parsed are not indexed, their errors are shown when they are drawn
+        if (page_is_tokenized(page)) {
+            search_add_page(search_index, page);
+        }
+    }
+
+    error_reset();
+
+    if (search_pending) {
+        search_pending = false;
+        run_search();
+    }
+}
+
+/// @brief Parses and indexes the cached pages that have not been indexed yet on a worker
+/// @return true if the pages are being indexed, false if every cached page is indexed
+static bool index_cached_pages() {
+    if (tokenize_job) {
+        return true;
+    }
+
+    size_t count = 0;
+
+    for (uint16_t id = 0; id <= CACHE_MAX_PAGE_ID; id++) {
+        page_t *page = unindexed_pages[id] ? cache_peek(cache, id) : NULL;
+
+        if (page && page_is_tokenized(page)) {
+            unindexed_pages[id] = false;
+            search_add_page(search_index, page);
+        } else if (page) {
+            count++;
+        } else {
+            unindexed_pages[id] = false;
+        }
+    }
+
+    if (count == 0) {
+        return false;
+    }
+
+    page_collection_t *pages = page_collection_create(count);
+    count = 0;
+
+    for (uint16_t id = 0; id <= CACHE_MAX_PAGE_ID; id++) {
+        page_t *page = unindexed_pages[id] ? cache_peek(cache, id) : NULL;
+        page_t *copy = page ? page_create_empty() : NULL;
+        unindexed_pages[id] = false;
+
+        if (!copy) {
+            continue;
+        }
+
+        // The worker parses a copy, since the cached page can be drawn or replaced meanwhile
+        copy->id = page->id;
+        copy->serial = page->serial;
+        copy->content = strndup(page->content, page->content_length);
+        copy->content_length = page->content_length;
+        pages->pages[count++] = copy;
+    }
+
+    // Fewer pages if there was not enough memory for every copy
+    pages->size = count;
+
+    tokenize_job = workers_create_job(WORKER_JOB_TOKENIZE, 0, 0, handle_tokenized_pages, NULL);
+
+    if (!tokenize_job) {
+        page_collection_destroy(pages);
+        return false;
+    }
+
+    tokenize_job->pages = pages;
+    workers_submit(tokenize_job, SCHEDULER_PRIORITY_LOCAL);
+    return true;
+}
+
+/// @brief Jumps to the page that best matches the query, or to the next hit of
+///        the last search if the query is empty
+static void search_pages(const char *query) {
+    if (query[0] == '\0') {
+        if (search_hit_count > 0) {
+            search_hit_position = (search_hit_position + 1) % search_hit_count;
+            show_search_hit();
         }
 
         return;
     }
 
-    page_collection_resize(collection, collection->size + 1);
-    collection->pages[collection->size - 1] = page;
-    set_page_index(collection->size - 1);
+    // Start indexing the rest of the pages the first time something is searched for
+    if (is_indexing()) {
+        events_set_timer(index_timer, INDEX_DELAY_MS, 0);
+    }
+
+    snprintf(search_query_buf, COMMAND_BUF_SIZE, "%s", query);
+
+    // The search is run once the worker has indexed the cached pages
+    if (index_cached_pages()) {
+        search_pending = true;
+        return;
+    }
+
+    run_search();
+}
+
+static void show_crawl_progress(crawler_progress_t *progress, void *data) {
+    char message[MESSAGE_BUF_SIZE];
+
+    if (!progress->finished) {
+        snprintf(
+            message,
+            MESSAGE_BUF_SIZE,
+            "Crawling %d%%, %zu pages, %" PRIu64 " s left",
+            progress->done * 100 / progress->total,
+            progress->pages,
+            (progress->remaining_ms + 999) / 1000
+        );
+    } else if (!error_is_set()) {
+        // Every page has been indexed as well
+        next_index_id = INDEX_LAST_PAGE + 1;
+        snprintf(message, MESSAGE_BUF_SIZE, "Stored all pages for offline use");
+    } else if (error_get() == TTT_ERROR_REQUEST_CANCELLED) {
+        snprintf(message, MESSAGE_BUF_SIZE, "Crawl stopped");
+    } else {
+        snprintf(message, MESSAGE_BUF_SIZE, "%s", error_get_string());
+    }
+
+    draw_command_message(command_win, message);
+}
+
+/// @brief Stores every page so that they can be shown offline, any key stops the crawl.
+///        The workers fetch the pages while the input is handled as usual.
+static void crawl() {
+    char message[MESSAGE_BUF_SIZE] = "Crawling 0%";
+
+    if (crawler_is_running()) {
+        snprintf(message, MESSAGE_BUF_SIZE, "Already crawling");
+    } else if (!crawler_start(store, search_index, show_crawl_progress, NULL)) {
+        snprintf(message, MESSAGE_BUF_SIZE, "%s", error_get_string());
+        error_reset();
+    }
+
+    draw_command_message(command_win, message);
+}
+
+/// @brief Returns the next or previous page in the chain that the server provides,
+///        falling back to the adjacent page number if the current page is not known yet
+static uint16_t get_adjacent_page_id(bool next) {
+    page_t *page = cache_get(cache, current_page_id);
+    uint16_t id = 0;
+
+    if (page) {
+        id = next ? page->next_id : page->prev_id;
+    }
+
+    if (!is_valid_page_id(id)) {
+        id = next ? current_page_id + 1 : current_page_id - 1;
+    }
+
+    return id;
 }
 
 static void previous_page() {
-    if (draw_get_current_view() != VIEW_MAIN || current_page_id == TTT_PAGE_HOME) {
+    if (draw_get_current_view() != VIEW_MAIN) {
         return;
     }
 
-    current_page_id -= 1;
-    set_page(current_page_id);
+    uint16_t id = get_adjacent_page_id(false);
+
+    // Do not wrap around from the first page
+    if (is_valid_page_id(id) && id < current_page_id) {
+        navigate_to(id);
+    }
 }
 
 static void next_page() {
-    if (draw_get_current_view() != VIEW_MAIN || current_page_id == TTT_PAGE_CONTENTS) {
+    if (draw_get_current_view() != VIEW_MAIN) {
         return;
     }
 
-    current_page_id += 1;
-    set_page(current_page_id);
+    uint16_t id = get_adjacent_page_id(true);
+
+    // Do not wrap around from the last page
+    if (is_valid_page_id(id) && id > current_page_id) {
+        navigate_to(id);
+    }
 }
 
 static void undo_follow_highlighted_link() {
-    if (draw_get_current_view() != VIEW_MAIN || previous_page_index == -1) {
+    if (draw_get_current_view() != VIEW_MAIN) {
         return;
     }
 
-    // Save the previous link index so that we can set it after rendering the page
-    int link_index = previous_page_link_index;
-    set_page_index(previous_page_index);
+    save_history_state();
+    history_entry_t *entry = history_back(history);
 
-    if (link_index != -1) {
-        draw_set_highlighted_link_index(content_win, link_index);
+    if (entry) {
+        show_history_entry(entry);
+    }
+}
+
+static void redo_follow_highlighted_link() {
+    if (draw_get_current_view() != VIEW_MAIN) {
+        return;
+    }
+
+    save_history_state();
+    history_entry_t *entry = history_forward(history);
+
+    if (entry) {
+        show_history_entry(entry);
     }
 }
 
@@ -100,20 +798,109 @@ static void follow_highlighted_link() {
     uint16_t href = draw_get_highlighted_link_href();
 
     if (href >= TTT_PAGE_HOME) {
-        set_page(href);
+        navigate_to(href);
     } else {
         draw_error("ERROR: No or invalid link selected");
     }
 }
 
-static void reset_command_mode_input(char buf[256], int *buf_length, bool *command_mode) {
+static void follow_clicked_link() {
+    MEVENT event;
+
+    if (getmouse(&event) != OK || !(event.bstate & BUTTON1_CLICKED)) {
+        return;
+    }
+
+    int line = event.y;
+    int col = event.x;
+
+    // Convert screen coordinates to window coordinates
+    if (!wmouse_trafo(content_win, &line, &col, FALSE)) {
+        return;
+    }
+
+    int link_index = draw_get_link_at(line, col);
+
+    if (link_index == -1) {
+        return;
+    }
+
+    draw_set_highlighted_link_index(content_win, link_index);
+    follow_highlighted_link();
+}
+
+static void select_link_by_number(const char *number) {
+    int link_number = atoi(number);
+
+    if (link_number < 1) {
+        draw_command_message(command_win, "Invalid link number");
+        return;
+    }
+
+    // Links are numbered from 1 in the order that they appear on the page
+    if (draw_get_current_view() == VIEW_MAIN) {
+        draw_set_highlighted_link_index(content_win, link_number - 1);
+    }
+}
+
+/// @brief Checks if there is another key waiting to be read, without consuming it
+static bool input_pending() {
+    int key = wgetch(content_win);
+
+    if (key == ERR) {
+        return false;
+    }
+
+    ungetch(key);
+    return true;
+}
+
+static void show_bytes_written() {
+    char message[MESSAGE_BUF_SIZE];
+    snprintf(
+        message,
+        MESSAGE_BUF_SIZE,
+        "Page: %" PRIu64 " B, total: %" PRIu64 " B",
+        draw_get_page_bytes(),
+        output_get_bytes_written()
+    );
+    draw_command_message(command_win, message);
+}
+
+/// @brief Shows how many of the predicted pages that were fetched have been used
+static void show_prediction_stats() {
+    char message[MESSAGE_BUF_SIZE];
+    unsigned int hit_rate = predicted_fetch_count ? prediction_hit_count * 100 / predicted_fetch_count : 0;
+    snprintf(
+        message,
+        MESSAGE_BUF_SIZE,
+        "Predicted: %u%% hits, %u/%u wasted",
+        hit_rate,
+        predicted_fetch_count - prediction_hit_count,
+        predicted_fetch_count
+    );
+    draw_command_message(command_win, message);
+}
+
+/// @brief Stops fetching the pages that a partially typed page number could end up as
+static void cancel_speculation() {
+    if (speculation_job) {
+        workers_cancel(speculation_job);
+        speculation_job = NULL;
+    }
+
+    speculated_start = 0;
+    speculated_end = 0;
+}
+
+static void reset_command_mode_input(char buf[COMMAND_BUF_SIZE], int *buf_length, bool *command_mode) {
     buf[*buf_length] = '\0';
     *buf_length = 0;
     *command_mode = false;
     draw_command_message(command_win, NULL);
 }
 
-static void remove_command_mode_key(char buf[256], int *buf_length) {
+static void remove_command_mode_key(char buf[COMMAND_BUF_SIZE], int *buf_length) {
     if (*buf_length == 0) {
         return;
     }
@@ -123,7 +910,7 @@ static void remove_command_mode_key(char buf[256], int *buf_length) {
     draw_command_key_remove(command_win, *buf_length);
 }
 
-static void execute_command_mode_input(char buf[256], int length, int *break_loop) {
+static void execute_command_mode_input(char buf[COMMAND_BUF_SIZE], int length, int *break_loop) {
     // Clear input window
     draw_command_message(command_win, NULL);
 
@@ -132,6 +919,31 @@ static void execute_command_mode_input(char buf[256], int length, int *break_loo
         return;
     }
 
+    if (strcmp(buf, BYTES_COMMAND) == 0) {
+        show_bytes_written();
+        return;
+    }
+
+    if (strcmp(buf, STATS_COMMAND) == 0) {
+        show_prediction_stats();
+        return;
+    }
+
+    if (strcmp(buf, CRAWL_COMMAND) == 0) {
+        crawl();
+        return;
+    }
+
+    if (buf[0] == LINK_COMMAND_PREFIX) {
+        select_link_by_number(buf + 1);
+        return;
+    }
+
+    if (buf[0] == SEARCH_COMMAND_PREFIX) {
+        search_pages(buf + 1);
+        return;
+    }
+
     if (length == 0 || length > PAGE_ID_MAX_LENGTH) {
         return;
     }
@@ -143,7 +955,7 @@ static void execute_command_mode_input(char buf[256], int length, int *break_loo
         return;
     }
 
-    set_page(id);
+    navigate_to(id);
 }
 
 static void create_win() {
@@ -153,6 +965,12 @@ static void create_win() {
                       (LINES - PAGE_LINES) / 2,
                       (COLS - PAGE_COLS) / 2
                   );
+
+    if (content_win) {
+        keypad(content_win, TRUE);
+        // Keys are read until there are no more when stdin becomes readable
+        nodelay(content_win, TRUE);
+    }
 }
 
 static void create_command_win() {
@@ -166,10 +984,22 @@ static void create_command_win() {
 }
 
 static void resize_win() {
-    endwin();
-    clear();
-    refresh();
-    getmaxyx(stdscr, LINES, COLS);
+    struct winsize size;
+
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == -1) {
+        return;
+    }
+
+    // Nothing has moved, e.g. if the window was resized back to its original size
+    if (content_win && size.ws_row == LINES && size.ws_col == COLS) {
+        return;
+    }
+
+    // SIGWINCH is read from a signalfd, so curses never sees the signal itself.
+    // Curses clears the screen after resizing, since the terminal contents are unknown.
+    resizeterm(size.ws_row, size.ws_col);
+    erase();
+    wnoutrefresh(stdscr);
 
     // If the window size is larger than the size of the terminal
     // at launch, the window will no be created correctly.
@@ -188,126 +1018,411 @@ static void resize_win() {
     // TODO: Move window to edges if the screen does not fit the window
     mvwin(content_win, (LINES - PAGE_LINES) / 2, (COLS - PAGE_COLS) / 2);
     mvwin(command_win, (LINES - PAGE_LINES) / 2 + PAGE_LINES, (COLS - PAGE_COLS) / 2);
+    touchwin(command_win);
+    wnoutrefresh(command_win);
+    // Show the current frame at the new position, everything is written with a single update
     draw_refresh_current(content_win, current_page);
 }
 
-static void resize_handler(int sig) {
-    resize_win();
+static void handle_resize(void *data) {
+    // Only relayout once the size has settled, e.g. when a window is being dragged
+    events_set_timer(resize_timer, RESIZE_DELAY_MS, 0);
 }
 
-void ui_initialize(bool overwrite_colors, bool transparent_background) {
-    setlocale(LC_ALL, "");
-    initscr();
-    noecho();
-    nodelay(stdscr, TRUE);
-    curs_set(0);
-    api_initialize();
-    collection = page_collection_create(0);
-    colors_initialize(overwrite_colors, transparent_background);
-    create_win();
-    create_command_win();
-    signal(SIGWINCH, resize_handler);
-    refresh();
-    set_page(current_page_id);
+static void handle_resize_timeout(void *data) {
+    resize_win();
 }
 
-void ui_event_loop() {
-    int key;
-    int buf_length = 0;
+/// @brief Handles a single key
+/// @return false if the program should quit
+static bool handle_key(int key) {
     int break_loop = 0;
-    char buf[256];
-    bool command_mode = false;
 
-    while (true) {
-        // https://stackoverflow.com/questions/3808626/ncurses-refresh/3808913#3808913
-        key = wgetch(content_win);
+    if (command_mode) {
+        switch (key) {
+        case ESCAPE:
+            reset_command_mode_input(command_buf, &command_buf_length, &command_mode);
+            cancel_speculation();
+            break;
 
-        if (command_mode) {
-            switch (key) {
-            case ESCAPE:
-                reset_command_mode_input(buf, &buf_length, &command_mode);
-                break;
+        case DELETE:
+        case BACKSPACE:
+        case KEY_BACKSPACE:
+            remove_command_mode_key(command_buf, &command_buf_length);
+            events_set_timer(speculation_timer, SPECULATION_DELAY_MS, 0);
+            break;
 
-            case DELETE:
-            case BACKSPACE:
-                remove_command_mode_key(buf, &buf_length);
-                break;
+        case '\n':
+            reset_command_mode_input(command_buf, &command_buf_length, &command_mode);
+            execute_command_mode_input(command_buf, command_buf_length - 1, &break_loop);
 
-            case '\n':
-                reset_command_mode_input(buf, &buf_length, &command_mode);
-                execute_command_mode_input(buf, buf_length - 1, &break_loop);
+            if (break_loop) {
+                return false;
+            }
 
-                if (break_loop) {
-                    return;
-                }
+            // Only the page that the user is waiting for is worth the rest of the range
+            if (navigation_target < speculated_start || navigation_target > speculated_end) {
+                cancel_speculation();
+            }
 
-                break;
+            break;
 
-            // Colon is not a valid command character
-            case ':':
-                break;
+        // Colon is not a valid command character
+        case ':':
+            break;
 
-            default:
-                draw_command_key(command_win, key, buf_length);
-                buf[buf_length] = key;
-                buf_length++;
+        default:
+            // Ignore function keys, e.g. arrow keys and mouse events
+            if (key > UCHAR_MAX || command_buf_length >= COMMAND_BUF_SIZE - 1) {
                 break;
             }
-        } else {
-            switch (key) {
-            case ':':
-                draw_command_start(command_win);
-                command_mode = true;
-                break;
 
-            case 'h':
-            case 'p':
-                previous_page();
-                break;
+            draw_command_key(command_win, key, command_buf_length);
+            command_buf[command_buf_length] = key;
+            command_buf_length++;
+            // Start fetching the pages that the page number could end up as
+            events_set_timer(speculation_timer, SPECULATION_DELAY_MS, 0);
+            break;
+        }
+    } else {
+        switch (key) {
+        case ':':
+            draw_command_start(command_win);
+            command_mode = true;
+            break;
 
-            case 'j':
-                draw_next_link(content_win);
-                break;
+        case SEARCH_COMMAND_PREFIX:
+            // Shortcut for ":/"
+            draw_command_start(command_win);
+            draw_command_key(command_win, key, 0);
+            command_buf[0] = key;
+            command_buf_length = 1;
+            command_mode = true;
+            break;
 
-            case 'k':
-                draw_previous_link(content_win);
-                break;
+        case 'h':
+        case 'p':
+            previous_page();
+            break;
 
-            case 'l':
-            case 'n':
-                next_page();
-                break;
+        case 'j':
+            draw_next_link(content_win);
+            break;
 
-            case '?':
-                draw_toggle_help(content_win, current_page);
-                break;
+        case 'k':
+            draw_previous_link(content_win);
+            break;
 
-            case '\n':
-                follow_highlighted_link();
-                break;
+        case KEY_UP:
+            draw_move_link(content_win, LINK_DIRECTION_UP);
+            break;
 
-            case 'u':
-            case 'b':
-                undo_follow_highlighted_link();
-                break;
+        case KEY_DOWN:
+            draw_move_link(content_win, LINK_DIRECTION_DOWN);
+            break;
 
-            case 'i':
-                set_page(TTT_PAGE_CONTENTS);
-                break;
+        case KEY_LEFT:
+            draw_move_link(content_win, LINK_DIRECTION_LEFT);
+            break;
 
-            case 's':
-                set_page(TTT_PAGE_HOME);
-                break;
+        case KEY_RIGHT:
+            draw_move_link(content_win, LINK_DIRECTION_RIGHT);
+            break;
 
-            case 'q':
-                return;
-            }
+        case KEY_MOUSE:
+            follow_clicked_link();
+            break;
+
+        case 'l':
+        case 'n':
+            next_page();
+            break;
+
+        case '?':
+            draw_toggle_help(content_win, current_page);
+            break;
+
+        case '\n':
+            follow_highlighted_link();
+            break;
+
+        case 'u':
+        case 'b':
+            undo_follow_highlighted_link();
+            break;
+
+        case 'f':
+            redo_follow_highlighted_link();
+            break;
+
+        case 'r':
+            toggle_live_mode();
+            break;
+
+        case 'i':
+            navigate_to(TTT_PAGE_CONTENTS);
+            break;
+
+        case 's':
+            navigate_to(TTT_PAGE_HOME);
+            break;
+
+        case 'q':
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// @brief Reads every key that is available when stdin becomes readable
+static void handle_input(void *data) {
+    int key;
+
+    if (!content_win) {
+        // The terminal is too small for the window, ignore the keys until it is resized
+        while (getch() != ERR) {}
+
+        return;
+    }
+
+    // https://stackoverflow.com/questions/3808626/ncurses-refresh/3808913#3808913
+    while ((key = wgetch(content_win)) != ERR) {
+        crawler_stop();
+
+        if (drop_frames) {
+            // Only draw the frame of the last key if keys are repeated faster than we can draw
+            draw_set_deferred(input_pending());
         }
+
+        if (!handle_key(key)) {
+            events_stop();
+            return;
+        }
+
+        draw_flush();
+    }
+}
+
+/// @brief Returns the range of pages that a partially typed page number can end up as,
+///        e.g. 300-399 for "3" and 330-339 for "33"
+/// @return false if the input is not the start of a page number
+static bool get_typed_page_range(const char *input, int length, uint16_t *start, uint16_t *end) {
+    if (length < 1 || length > PAGE_ID_MAX_LENGTH || input[0] < '1' || input[0] > '9') {
+        return false;
+    }
+
+    int prefix = 0;
+    int scale = 1;
+
+    for (int i = 0; i < length; i++) {
+        if (input[i] < '0' || input[i] > '9') {
+            return false;
+        }
+
+        prefix = prefix * 10 + input[i] - '0';
+    }
+
+    for (int i = length; i < PAGE_ID_MAX_LENGTH; i++) {
+        scale *= 10;
+    }
+
+    *start = prefix * scale;
+    *end = *start + scale - 1;
+    return true;
+}
+
+static void handle_speculated_pages(worker_job_t *job) {
+    page_collection_t *pages = job->pages;
+
+    if (speculation_job == job) {
+        speculation_job = NULL;
+    }
+
+    for (size_t i = 0; pages && i < pages->size; i++) {
+        store_page(pages->pages[i]);
+    }
+
+    if (pages) {
+        // The pages are owned by the cache
+        pages->size = 0;
+    }
+
+    // Show the page that the user is waiting for, or fetch it on its own if it was not
+    // in the response, e.g. since it does not exist
+    if (navigation_target >= job->start && navigation_target <= job->end) {
+        set_page(navigation_target);
+    }
+}
+
+static void handle_speculation_timeout(void *data) {
+    uint16_t start, end;
+
+    if (!command_mode) {
+        return;
+    }
+
+    // E.g. the number has been erased or the input has become a command
+    if (!get_typed_page_range(command_buf, command_buf_length, &start, &end)) {
+        cancel_speculation();
+        return;
+    }
+
+    // Only fetch the pages that are not cached or already being fetched
+    while (start <= end && cache_contains(cache, start)) {
+        start++;
+    }
+
+    while (end > start && cache_contains(cache, end)) {
+        end--;
+    }
+
+    if (start > end || (speculation_job && start >= speculated_start && end <= speculated_end)) {
+        return;
+    }
+
+    // The page number can no longer end up as one of the pages that are being fetched
+    cancel_speculation();
+    speculated_start = start;
+    speculated_end = end;
+
+    if (start == end) {
+        fetch_page(start, SCHEDULER_PRIORITY_TYPED);
+        return;
+    }
+
+    speculation_job = workers_create_job(WORKER_JOB_PAGE_RANGE, start, end, handle_speculated_pages, NULL);
+
+    if (speculation_job) {
+        workers_submit(speculation_job, SCHEDULER_PRIORITY_TYPED);
     }
 }
 
+static void handle_completed_jobs(void *data) {
+    workers_handle_completed();
+}
+
+void ui_initialize(bool overwrite_colors, bool transparent_background, draw_backend_t backend, bool low_bandwidth) {
+    startup_ms = get_time_ms();
+    cache = cache_create(PAGE_CACHE_CAPACITY);
+    history = history_create(cache, HISTORY_CAPACITY);
+    search_index = search_create();
+    // Pages can still be shown without the store, but not offline
+    store = store_open(NULL);
+    transitions = transitions_create();
+
+    // What has been learned is kept next to the stored pages
+    if (store && transitions) {
+        snprintf(transitions_path, PATH_MAX, "%s/%s", store_get_path(store), TRANSITIONS_FILE_NAME);
+        transitions_load(transitions, transitions_path);
+    }
+
+    // Continue where the user left off
+    uint16_t last_page_id = store ? store_get_last_page(store) : 0;
+
+    if (is_valid_page_id(last_page_id)) {
+        current_page_id = last_page_id;
+    }
+
+    error_reset();
+
+    if (events_initialize()) {
+        resize_timer = events_add_timer(handle_resize_timeout, NULL);
+        navigation_timer = events_add_timer(handle_navigation_timeout, NULL);
+        prefetch_timer = events_add_timer(handle_prefetch_timeout, NULL);
+        speculation_timer = events_add_timer(handle_speculation_timeout, NULL);
+        live_timer = events_add_timer(handle_live_timeout, NULL);
+        index_timer = events_add_timer(handle_index_timeout, NULL);
+    }
+
+    if (resize_timer == EVENTS_INVALID_SOURCE ||
+            navigation_timer == EVENTS_INVALID_SOURCE ||
+            prefetch_timer == EVENTS_INVALID_SOURCE ||
+            speculation_timer == EVENTS_INVALID_SOURCE ||
+            live_timer == EVENTS_INVALID_SOURCE ||
+            index_timer == EVENTS_INVALID_SOURCE ||
+            events_add_fd(STDIN_FILENO, handle_input, NULL) == EVENTS_INVALID_SOURCE ||
+            events_add_signal(SIGWINCH, handle_resize, NULL) == EVENTS_INVALID_SOURCE) {
+        printf("Failed to initialize event loop");
+        exit(1);
+    }
+
+    // The workers inherit the signal mask, so they are started after SIGWINCH has been blocked
+    if (!workers_initialize(WORKER_COUNT) ||
+            events_add_fd(workers_get_fd(), handle_completed_jobs, NULL) == EVENTS_INVALID_SOURCE) {
+        printf("Failed to start the workers");
+        exit(1);
+    }
+
+    // The first page is fetched while the terminal is set up, and shown by the
+    // event loop once both are done, since nothing is drawn until it runs
+    set_page(current_page_id);
+
+    setlocale(LC_ALL, "");
+    // Count everything that is sent to the terminal, including the setup
+    output_initialize(backend == DRAW_BACKEND_CURSES);
+    initscr();
+    noecho();
+    nodelay(stdscr, TRUE);
+    curs_set(0);
+    // Do not wait long for the rest of an escape sequence when escape is pressed
+    set_escdelay(ESCAPE_DELAY_MS);
+    mousemask(BUTTON1_CLICKED, NULL);
+    colors_initialize(overwrite_colors, transparent_background);
+
+    if (backend == DRAW_BACKEND_ANSI) {
+        // Only use the exact colors if we have overwritten the terminal colors
+        ansi_initialize(overwrite_colors && ansi_supports_truecolor(), low_bandwidth);
+    }
+
+    drop_frames = low_bandwidth;
+
+    draw_set_backend(backend);
+    create_win();
+    create_command_win();
+    refresh();
+    terminal_ready_ms = get_time_ms();
+}
+
+void ui_event_loop() {
+    // Sleeps until there is input or a signal, instead of polling for keys
+    events_run();
+}
+
 void ui_destroy() {
-    page_collection_destroy(collection);
+    events_destroy();
+    workers_destroy();
+    // The history unpins its pages, so it goes before the cache
+    history_destroy(history);
+    cache_destroy(cache);
+    search_destroy(search_index);
+
+    if (store) {
+        store_set_last_page(store, current_page ? current_page->id : current_page_id);
+    }
+
+    if (store && transitions) {
+        transitions_save(transitions, transitions_path);
+    }
+
+    transitions_destroy(transitions);
+    store_close(store);
     delwin(content_win);
     endwin();
+    output_destroy();
+}
+
+/// @brief Prints how long it took to start, must be called after 'ui_destroy()'
+void ui_print_startup_timing() {
+    printf("Terminal ready after %" PRIu64 " ms\n", terminal_ready_ms - startup_ms);
+
+    if (first_page_ms) {
+        printf("First page fetched after %" PRIu64 " ms\n", first_page_ms - startup_ms);
+    }
+
+    if (first_paint_ms) {
+        printf("First page shown after %" PRIu64 " ms\n", first_paint_ms - startup_ms);
+    } else {
+        printf("No page was shown\n");
+    }
 }
@@ -2,13 +2,26 @@
 #include <curses.h>
 #include <signal.h>
 #include <locale.h>
+#include <inttypes.h>
+#include <time.h>
+#include <sys/ioctl.h>
 
 #include "api.h"
 #include "draw.h"
 #include "pages.h"
+#include "cache.h"
+#include "history.h"
+#include "search.h"
+#include "store.h"
+#include "transitions.h"
+#include "crawler.h"
+#include "workers.h"
 #include "colors.h"
+#include "output.h"
+#include "events.h"
 #include "shared.h"
 
-void ui_initialize(bool overwrite_colors, bool transparent_background);
+void ui_initialize(bool overwrite_colors, bool transparent_background, draw_backend_t backend, bool low_bandwidth);
 void ui_event_loop();
 void ui_destroy();
+void ui_print_startup_timing();
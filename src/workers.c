@@ -0,0 +1,442 @@
+#include "workers.h"
+
+// Requests are made and parsed by a pool of threads, so that the thread that
+// draws never waits for the network. The workers take the jobs from a scheduler
+// that is protected by a mutex, since they have nothing else to do while they wait.
+// It decides which job runs next from their priorities and the rate limit.
+// The completed jobs are handed back through a lock-free queue, and the eventfd
+// wakes up the event loop of the thread that handles them.
+static pthread_t threads[WORKERS_MAX_THREADS];
+static int thread_count = 0;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_available;
+static scheduler_t scheduler;
+static worker_job_t *running_jobs[WORKERS_MAX_THREADS];
+static bool stopping = false;
+static queue_t completed_jobs;
+static int event_fd = -1;
+static _Thread_local worker_job_t *current_job = NULL;
+
+static bool is_current_job_cancelled() {
+    return current_job && (atomic_load(&current_job->cancelled) || atomic_load(&current_job->preempted));
+}
+
+static uint64_t get_time_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static worker_job_t *get_job(scheduler_entry_t *entry) {
+    return (worker_job_t *)((char *)entry - offsetof(worker_job_t, entry));
+}
+
+/// @param max_age the oldest page that should be returned in seconds, 0 for any age
+static page_t *read_stored_page(worker_job_t *job, time_t max_age) {
+    time_t stored_at;
+    page_t *page = store_get_page(job->store, job->start, &stored_at);
+
+    if (page && max_age && time(NULL) - stored_at > max_age) {
+        page_destroy(page);
+        return NULL;
+    }
+
+    if (page) {
+        job->stored_at = stored_at;
+    }
+
+    return page;
+}
+
+static void run_page_job(worker_job_t *job) {
+    if (job->store && job->max_stored_age) {
+        job->page = read_stored_page(job, job->max_stored_age);
+
+        if (job->page) {
+            return;
+        }
+    }
+
+    job->requested = true;
+    job->page = api_get_page(job->start);
+
+    if (!job->page && job->store && error_get() == TTT_ERROR_REQUEST_FAILED) {
+        job->page = read_stored_page(job, 0);
+        job->offline = job->page != NULL;
+    }
+}
+
+/// @brief Fetches a range of pages and stores them as they were received, so that
+///        they can be shown offline
+static void run_crawl_job(worker_job_t *job) {
+    size_t size;
+    char *data = api_get_page_range_data(job->start, job->end, &size);
+
+    if (data) {
+        job->pages = store_put_range(job->store, job->start, job->end, data, size);
+        free(data);
+    }
+}
+
+/// @brief Parses the HTML of the pages of a job, so that the thread that draws only
+///        handles pages that are already parsed. Pages that can not be parsed keep their
+///        content, and the error is shown when they are drawn.
+static void tokenize_pages(worker_job_t *job) {
+    page_get_tokens(job->page);
+
+    for (size_t i = 0; job->pages && i < job->pages->size; i++) {
+        page_get_tokens(job->pages->pages[i]);
+    }
+
+    error_reset();
+}
+
+static void run_job(worker_job_t *job) {
+    error_reset();
+    job->requested = false;
+
+    if (atomic_load(&job->cancelled)) {
+        error_set(TTT_ERROR_REQUEST_CANCELLED);
+    } else if (job->type == WORKER_JOB_PAGE) {
+        run_page_job(job);
+    } else if (job->type == WORKER_JOB_PAGE_UPDATE) {
+        job->requested = true;
+        job->page = api_get_page_if_modified(job->start, job->modified_since);
+    } else if (job->type == WORKER_JOB_PAGE_RANGE) {
+        job->requested = true;
+        job->pages = api_get_page_range(job->start, job->end);
+    } else if (job->type == WORKER_JOB_CRAWL_RANGE) {
+        job->requested = true;
+        run_crawl_job(job);
+    }
+
+    if (job->type == WORKER_JOB_TOKENIZE || atomic_load(&job->tokenize)) {
+        tokenize_pages(job);
+    }
+
+    // The errors belong to this thread, so they are returned with the job
+    if (!job->page && !job->pages) {
+        error_save(&job->error);
+    }
+
+    error_reset();
+}
+
+static void complete_job(worker_job_t *job) {
+    uint64_t wake = 1;
+
+    // Only the first job has to wake up the event loop, since it takes every job at once.
+    // Writing can only fail if the counter overflows, which it would already have woken up.
+    if (queue_push(&completed_jobs, &job->node)) {
+        write(event_fd, &wake, sizeof(wake));
+    }
+}
+
+/// @brief Puts a job that was stopped for a job with a higher priority back in the scheduler
+/// @return false if the job was completed or cancelled before it could be stopped
+static bool requeue_preempted_job(worker_job_t *job) {
+    if (!atomic_exchange(&job->preempted, false) || atomic_load(&job->cancelled)) {
+        return false;
+    }
+
+    if (job->error.code != TTT_ERROR_REQUEST_CANCELLED) {
+        return false;
+    }
+
+    job->error = (error_context_t){TTT_ERROR_NONE, ""};
+    scheduler_requeue(&scheduler, &job->entry);
+    return true;
+}
+
+/// @brief Stops the jobs that would compete with the page that the user is waiting for
+static void preempt_background_jobs() {
+    for (int i = 0; i < thread_count; i++) {
+        worker_job_t *job = running_jobs[i];
+
+        if (job && scheduler_yields_to_visible(job->entry.priority)) {
+            atomic_store(&job->preempted, true);
+        }
+    }
+}
+
+/// @param wait_ms how long to wait at most, 0 to wait until the workers are signalled
+static void wait_for_job(uint64_t wait_ms) {
+    if (!wait_ms) {
+        pthread_cond_wait(&job_available, &lock);
+        return;
+    }
+
+    struct timespec until;
+    clock_gettime(CLOCK_MONOTONIC, &until);
+    until.tv_sec += wait_ms / 1000;
+    until.tv_nsec += (wait_ms % 1000) * 1000000;
+
+    if (until.tv_nsec >= 1000000000) {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000;
+    }
+
+    pthread_cond_timedwait(&job_available, &lock, &until);
+}
+
+static void *run_worker(void *data) {
+    int index = (int)(intptr_t)data;
+    api_set_cancel_check(is_current_job_cancelled);
+    trace_set_thread_name("worker");
+    pthread_mutex_lock(&lock);
+
+    while (!stopping) {
+        uint64_t wait_ms;
+        scheduler_entry_t *entry = scheduler_take(&scheduler, get_time_ms(), &wait_ms);
+
+        if (!entry) {
+            wait_for_job(wait_ms);
+            continue;
+        }
+
+        worker_job_t *job = get_job(entry);
+        running_jobs[index] = job;
+        pthread_mutex_unlock(&lock);
+
+        current_job = job;
+        trace_begin("job", job->start);
+        run_job(job);
+        trace_end("job", job->start);
+        current_job = NULL;
+        job->completed_ms = get_time_ms();
+
+        pthread_mutex_lock(&lock);
+        running_jobs[index] = NULL;
+        scheduler_finish(&scheduler, entry);
+
+        // Pages that were read from the store do not count toward the rate limit
+        if (!job->requested) {
+            scheduler_refund(&scheduler, entry);
+        }
+
+        if (!requeue_preempted_job(job)) {
+            complete_job(job);
+        }
+
+        // The slot that was freed might be the one that another job is waiting for
+        pthread_cond_broadcast(&job_available);
+    }
+
+    pthread_mutex_unlock(&lock);
+    api_thread_destroy();
+    return NULL;
+}
+
+static void destroy_job(worker_job_t *job) {
+    page_destroy(job->page);
+
+    if (job->pages) {
+        page_collection_destroy(job->pages);
+    }
+
+    free(job);
+}
+
+/// @brief Starts 'count' worker threads. 'api_initialize()' must have been called, and
+///        signals that are handled by the event loop must be blocked before this.
+bool workers_initialize(int count) {
+    if (count > WORKERS_MAX_THREADS) {
+        count = WORKERS_MAX_THREADS;
+    }
+
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&job_available, &attributes);
+    pthread_condattr_destroy(&attributes);
+
+    // One worker is left for the page that the user is waiting for, see 'scheduler_take()'
+    scheduler_initialize(&scheduler, count, WORKERS_REQUESTS_PER_SECOND, WORKERS_REQUEST_BURST);
+    queue_initialize(&completed_jobs);
+    stopping = false;
+    event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (event_fd == -1) {
+        return false;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (pthread_create(&threads[thread_count], NULL, run_worker, (void *)(intptr_t)i) != 0) {
+            break;
+        }
+
+        thread_count++;
+    }
+
+    return thread_count > 0;
+}
+
+/// @brief The fd becomes readable when there are completed jobs, see 'workers_handle_completed()'
+int workers_get_fd() {
+    return event_fd;
+}
+
+/// @brief Creates a job for the pages between start and end, 'end' is only used for ranges
+/// @param callback called with the completed job by 'workers_handle_completed()'
+worker_job_t *workers_create_job(
+    worker_job_type_t type,
+    uint16_t start,
+    uint16_t end,
+    worker_callback_t callback,
+    void *data
+) {
+    worker_job_t *job = calloc(1, sizeof(worker_job_t));
+
+    if (!job) {
+        error_set(TTT_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    job->type = type;
+    job->start = start;
+    job->end = end;
+    job->callback = callback;
+    job->data = data;
+    atomic_init(&job->cancelled, false);
+    atomic_init(&job->preempted, false);
+    atomic_init(&job->tokenize, false);
+    return job;
+}
+
+/// @brief The pages that are about to be shown are parsed by the worker, prefetched pages and
+///        ranges are only parsed if they are shown or searched, see 'page_get_tokens()'
+static void set_tokenize(worker_job_t *job, scheduler_priority_t priority) {
+    if (job->type == WORKER_JOB_PAGE && priority <= SCHEDULER_PRIORITY_TYPED) {
+        atomic_store(&job->tokenize, true);
+    }
+}
+
+/// @brief Hands the job to the first worker that is available and allowed to run it.
+///        The job is owned by the workers until its callback has been called.
+void workers_submit(worker_job_t *job, scheduler_priority_t priority) {
+    pthread_mutex_lock(&lock);
+    scheduler_add(&scheduler, &job->entry, priority);
+    set_tokenize(job, priority);
+
+    if (priority == SCHEDULER_PRIORITY_VISIBLE) {
+        preempt_background_jobs();
+    }
+
+    pthread_cond_signal(&job_available);
+    pthread_mutex_unlock(&lock);
+}
+
+/// @brief Raises the priority of a job that has been submitted, e.g. when the
+///        page of a prefetch becomes the page that the user is waiting for
+void workers_promote(worker_job_t *job, scheduler_priority_t priority) {
+    pthread_mutex_lock(&lock);
+    scheduler_promote(&scheduler, &job->entry, priority);
+    set_tokenize(job, priority);
+
+    if (priority == SCHEDULER_PRIORITY_VISIBLE) {
+        preempt_background_jobs();
+    }
+
+    pthread_cond_signal(&job_available);
+    pthread_mutex_unlock(&lock);
+}
+
+static void cancel_locked(worker_job_t *job) {
+    atomic_store(&job->cancelled, true);
+
+    if (job->entry.waiting) {
+        scheduler_remove(&scheduler, &job->entry);
+        job->error = (error_context_t){TTT_ERROR_REQUEST_CANCELLED, ""};
+        complete_job(job);
+    }
+}
+
+/// @brief Stops the request of a job as soon as possible, or skips it if it has not
+///        been started. The callback is still called, with TTT_ERROR_REQUEST_CANCELLED.
+void workers_cancel(worker_job_t *job) {
+    pthread_mutex_lock(&lock);
+    cancel_locked(job);
+    pthread_mutex_unlock(&lock);
+}
+
+/// @brief Cancels the jobs with the priority that have not been started
+void workers_cancel_waiting(scheduler_priority_t priority) {
+    pthread_mutex_lock(&lock);
+
+    while (scheduler.first[priority]) {
+        cancel_locked(get_job(scheduler.first[priority]));
+    }
+
+    pthread_mutex_unlock(&lock);
+}
+
+bool workers_is_cancelled(worker_job_t *job) {
+    return atomic_load(&job->cancelled);
+}
+
+/// @brief Calls the callbacks of the jobs that have been completed and destroys them
+void workers_handle_completed() {
+    uint64_t count;
+
+    // Consume the wake-up before taking the jobs, so that a job that is completed
+    // in between wakes up the event loop again instead of being missed. There might
+    // be no wake-up, if the jobs were taken together with the ones before them.
+    read(event_fd, &count, sizeof(count));
+
+    queue_node_t *node = queue_take_all(&completed_jobs);
+
+    while (node) {
+        // The node is the first member of the job
+        worker_job_t *job = (worker_job_t *)node;
+        node = node->next;
+
+        if (job->callback) {
+            job->callback(job);
+        }
+
+        destroy_job(job);
+    }
+}
+
+/// @brief Cancels every job and stops the workers, the callbacks of the jobs are not called
+void workers_destroy() {
+    pthread_mutex_lock(&lock);
+    stopping = true;
+
+    for (int i = 0; i < thread_count; i++) {
+        if (running_jobs[i]) {
+            atomic_store(&running_jobs[i]->cancelled, true);
+        }
+    }
+
+    pthread_cond_broadcast(&job_available);
+    pthread_mutex_unlock(&lock);
+
+    for (int i = 0; i < thread_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    thread_count = 0;
+
+    for (int i = 0; i < SCHEDULER_PRIORITY_COUNT; i++) {
+        while (scheduler.first[i]) {
+            worker_job_t *job = get_job(scheduler.first[i]);
+            scheduler_remove(&scheduler, &job->entry);
+            destroy_job(job);
+        }
+    }
+
+    pthread_cond_destroy(&job_available);
+    queue_node_t *node = queue_take_all(&completed_jobs);
+
+    while (node) {
+        worker_job_t *job = (worker_job_t *)node;
+        node = node->next;
+        destroy_job(job);
+    }
+
+    if (event_fd != -1) {
+        close(event_fd);
+        event_fd = -1;
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/eventfd.h>
+
+#include "api.h"
+#include "pages.h"
+#include "store.h"
+#include "queue.h"
+#include "scheduler.h"
+#include "errors.h"
+
+#define WORKERS_MAX_THREADS 8
+#define WORKERS_REQUESTS_PER_SECOND 10
+#define WORKERS_REQUEST_BURST 20
+
+typedef enum worker_job_type {
+    WORKER_JOB_PAGE,            // a page, read from the store if it is recent enough or offline
+    WORKER_JOB_PAGE_UPDATE,     // a page, only if it has been modified since 'modified_since'
+    WORKER_JOB_PAGE_RANGE,      // every page between 'start' and 'end'
+    WORKER_JOB_CRAWL_RANGE,     // every page between 'start' and 'end', written to 'store'
+    WORKER_JOB_TOKENIZE         // parses the HTML content of 'pages', which the job owns
+} worker_job_type_t;
+
+typedef struct worker_job worker_job_t;
+
+/// @brief Called on the thread that handles the completed jobs. The results that are
+///        kept must be set to NULL, the rest are destroyed together with the job.
+typedef void (*worker_callback_t)(worker_job_t *job);
+
+struct worker_job {
+    queue_node_t node;
+    worker_job_type_t type;
+    uint16_t start;
+    uint16_t end;
+    uint64_t modified_since;
+    page_store_t *store;        // NULL to always fetch the page, or where a crawl stores its pages
+    time_t max_stored_age;      // the oldest stored page that is used instead of fetching it
+    worker_callback_t callback;
+    void *data;
+    atomic_bool cancelled;
+    atomic_bool preempted;      // stopped to make room for a job with a higher priority
+    atomic_bool tokenize;       // parse the HTML of the fetched pages before completing the job
+    scheduler_entry_t entry;
+
+    // The results, set by the worker
+    page_t *page;
+    page_collection_t *pages;
+    bool offline;               // the request failed, the page was read from the store
+    bool requested;             // a request was made, instead of only reading the store
+    time_t stored_at;           // when the page was stored if it was read from the store
+    error_context_t error;      // set if there are no results
+    uint64_t completed_ms;      // when the worker was done, on a monotonic clock
+};
+
+bool workers_initialize(int count);
+int workers_get_fd();
+worker_job_t *workers_create_job(
+    worker_job_type_t type,
+    uint16_t start,
+    uint16_t end,
+    worker_callback_t callback,
+    void *data
+);
+void workers_submit(worker_job_t *job, scheduler_priority_t priority);
+void workers_promote(worker_job_t *job, scheduler_priority_t priority);
+void workers_cancel(worker_job_t *job);
+void workers_cancel_waiting(scheduler_priority_t priority);
+bool workers_is_cancelled(worker_job_t *job);
+void workers_handle_completed();
+void workers_destroy();
@@ -0,0 +1,622 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <curses.h>
+#include "../src/pages.h"
+#include "../src/parser.h"
+#include "../src/html_parser.h"
+#include "../src/cache.h"
+#include "../src/draw.h"
+#include "../src/colors.h"
+
+#define JSON_DATA_PAGE_PATH "./test/data/index.json"
+#define HTML_DATA_PAGE_PATHS {"./test/data/page1.html", "./test/data/page2.html", \
+                              "./test/data/page3.html", "./test/data/page4.html"}
+#define HTML_DATA_PAGE_COUNT 4
+
+#define BENCH_ROUNDS        15
+#define BENCH_ROUND_NS      50000000
+#define BENCH_NAME_SIZE     64
+#define MAX_BENCHES         32
+#define MAX_SUITES          8
+// The share that a benchmark can be slower than the baseline before it is a regression
+#define DEFAULT_TOLERANCE   0.3
+#define NOISY_TOLERANCE     0.6
+#define SYNTHETIC_LINES     200
+#define SYNTHETIC_RANGE     10
+#define CACHE_PAGE_COUNT    256
+#define CACHE_FIRST_PAGE_ID 100
+
+typedef struct file_data {
+    char *data;
+    size_t length;
+} file_data_t;
+
+typedef struct bench {
+    char name[BENCH_NAME_SIZE];
+    void (*run)(void *data);    // runs one operation
+    void *data;
+    size_t bytes;               // processed by each operation, 0 if it is not meaningful
+    double tolerance;           // written to new baselines, which can then be edited
+} bench_t;
+
+typedef struct bench_suite {
+    const char *name;
+    bench_t benches[MAX_BENCHES];
+    size_t count;
+} bench_suite_t;
+
+typedef struct bench_result {
+    char name[BENCH_NAME_SIZE];
+    uint64_t iterations;
+    double median_ns;
+    double low_ns;              // the 95% confidence interval of the median
+    double high_ns;
+    double mb_per_s;
+    double allocations;
+    double tolerance;
+} bench_result_t;
+
+// The allocations of the code that is measured are counted by wrapping the allocation
+// functions when linking, see the 'benchmarks' target in the makefile. Allocations
+// inside of the libraries, e.g. ncurses, are not counted.
+static uint64_t allocation_count = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    allocation_count++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    allocation_count++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size) {
+    allocation_count++;
+    return __real_realloc(pointer, size);
+}
+
+static file_data_t json_page;
+static file_data_t html_pages[HTML_DATA_PAGE_COUNT];
+static file_data_t synthetic_html;
+static file_data_t synthetic_range;
+static page_cache_t *cache = NULL;
+static uint32_t cache_cursor = 0;
+static WINDOW *win = NULL;
+static page_t *draw_pages[2];
+static int draw_cursor = 0;
+// Given to the pages of the cold draws, counting down so that they are never the serial of a created page
+static uint32_t cold_draw_serial = UINT32_MAX;
+static bench_suite_t suites[MAX_SUITES];
+static size_t suite_count = 0;
+
+static bool load_file(file_data_t *dest, const char *path) {
+    FILE *f = fopen(path, "r");
+
+    if (!f) {
+        return false;
+    }
+
+    fseek(f, 0, SEEK_END);
+    dest->length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    dest->data = calloc(dest->length + 1, sizeof(char));
+    bool loaded = dest->data && fread(dest->data, sizeof(char), dest->length, f) == dest->length;
+    fclose(f);
+    return loaded;
+}
+
+static bool append(file_data_t *dest, size_t *capacity, const char *str) {
+    size_t length = strlen(str);
+
+    if (dest->length + length + 1 > *capacity) {
+        *capacity = (dest->length + length + 1) * 2;
+        char *data = realloc(dest->data, *capacity);
+
+        if (!data) {
+            return false;
+        }
+
+        dest->data = data;
+    }
+
+    memcpy(dest->data + dest->length, str, length + 1);
+    dest->length += length;
+    return true;
+}
+
+static bool is_valid_html(file_data_t *file) {
+    page_t *page = page_create_empty();
+    html_parser_get_page_tokens(page, file->data, file->length);
+    bool valid = page && page->tokens;
+    page_destroy(page);
+    return valid;
+}
+
+/// @brief Creates a page that is much longer than the pages of the API, with a link and
+///        a change of colors on every line, escaped in the same way as in the responses
+static bool create_synthetic_html(file_data_t *dest) {
+    size_t capacity = 0;
+    char line[BENCH_NAME_SIZE * 2];
+    bool created = append(dest, &capacity, "<div class=\\\"root\\\"><span class=\\\"toprow\\\"> 100 SVT Text\\n <\\/span>");
+
+    for (int i = 0; i < SYNTHETIC_LINES && created; i++) {
+        snprintf(
+            line,
+            sizeof(line),
+            "<span class=\\\"Y bgB\\\">Line %d of the page <a href=\\\"\\/%d\\\">%d<\\/a><\\/span>\\n ",
+            i,
+            100 + i % 800,
+            100 + i % 800
+        );
+        created = append(dest, &capacity, line);
+    }
+
+    return created && append(dest, &capacity, "<\\/div>") && is_valid_html(dest);
+}
+
+/// @brief Creates the response of a range of pages, with the page of the test data repeated
+static bool create_synthetic_range(file_data_t *dest) {
+    // The test data is an array with one page
+    const char *start = strchr(json_page.data, '{');
+    const char *end = strrchr(json_page.data, '}');
+    size_t capacity = 0;
+    bool created = start && end && append(dest, &capacity, "[");
+
+    for (int i = 0; i < SYNTHETIC_RANGE && created; i++) {
+        char *object = strndup(start, end - start + 1);
+        created = object && append(dest, &capacity, i > 0 ? "," : "") && append(dest, &capacity, object);
+        free(object);
+    }
+
+    return created && append(dest, &capacity, "]");
+}
+
+static uint64_t get_time_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void run_parse_page(void *data) {
+    file_data_t *file = data;
+    page_destroy(parser_get_page(file->data, file->length));
+}
+
+static void run_parse_page_with_tokens(void *data) {
+    file_data_t *file = data;
+    page_t *page = parser_get_page(file->data, file->length);
+    page_get_tokens(page);
+    page_destroy(page);
+}
+
+static void run_parse_page_collection(void *data) {
+    file_data_t *file = data;
+    page_collection_t *collection = parser_get_page_collection(file->data, file->length);
+
+    if (collection) {
+        page_collection_destroy(collection);
+    }
+}
+
+static void run_html_tokens(void *data) {
+    file_data_t *file = data;
+    page_t *page = page_create_empty();
+    html_parser_get_page_tokens(page, file->data, file->length);
+    page_destroy(page);
+}
+
+static void run_page_create_destroy(void *data) {
+    page_destroy(page_create_empty());
+}
+
+static void run_cache_get(void *data) {
+    // A linear congruential generator, so that every run looks up the same pages
+    cache_cursor = cache_cursor * 1664525 + 1013904223;
+    cache_get(cache, CACHE_FIRST_PAGE_ID + (cache_cursor >> 16) % CACHE_PAGE_COUNT);
+}
+
+static void run_draw_cached(void *data) {
+    // Switch between two pages, so that every frame is different from the one before.
+    // Both stay in the frame cache, so this is the copy of the cached frame and the diff.
+    draw_cursor = !draw_cursor;
+    draw(win, VIEW_MAIN, draw_pages[draw_cursor]);
+}
+
+static void run_draw_cold(void *data) {
+    // Draws the pages as if they had just arrived, by dropping their grids and giving them
+    // serials that are not in the frame cache, so that they are laid out and rendered again
+    draw_cursor = !draw_cursor;
+    page_t *page = draw_pages[draw_cursor];
+    grid_destroy(page->grid);
+    page->grid = NULL;
+    page->serial = cold_draw_serial--;
+    draw(win, VIEW_MAIN, page);
+}
+
+/// @brief Runs the operation of a benchmark a number of times
+/// @return the time that it took in nanoseconds
+static uint64_t run_iterations(bench_t *bench, uint64_t iterations) {
+    uint64_t start = get_time_ns();
+
+    for (uint64_t i = 0; i < iterations; i++) {
+        bench->run(bench->data);
+    }
+
+    return get_time_ns() - start;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/// @brief Finds how many iterations take about one round, then runs several rounds and
+///        takes the median, which is not moved by a few rounds that were disturbed by
+///        everything else on the machine
+static void run_bench(bench_t *bench, bench_result_t *result) {
+    uint64_t iterations = 1;
+
+    // Warm up the caches and find the number of iterations
+    while (run_iterations(bench, iterations) < BENCH_ROUND_NS / 10) {
+        iterations *= 2;
+    }
+
+    iterations *= 10;
+    double ns[BENCH_ROUNDS];
+    uint64_t allocations = 0;
+
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        allocation_count = 0;
+        ns[i] = (double)run_iterations(bench, iterations) / iterations;
+        allocations = allocation_count;
+    }
+
+    qsort(ns, BENCH_ROUNDS, sizeof(double), compare_doubles);
+
+    // The 1-based ranks of the rounds that bound the median with 95% confidence, without
+    // assuming anything about how the times are distributed, as indexes of the sorted rounds
+    double spread = 1.96 * sqrt(BENCH_ROUNDS) / 2;
+    int low = ceil(BENCH_ROUNDS / 2.0 - spread) - 1;
+    int high = ceil(BENCH_ROUNDS / 2.0 + spread) - 1;
+
+    snprintf(result->name, BENCH_NAME_SIZE, "%s", bench->name);
+    result->iterations = iterations;
+    result->median_ns = ns[BENCH_ROUNDS / 2];
+    result->low_ns = ns[low > 0 ? low : 0];
+    result->high_ns = ns[high < BENCH_ROUNDS ? high : BENCH_ROUNDS - 1];
+    result->mb_per_s = bench->bytes ? bench->bytes / result->median_ns * 1000 : 0;
+    result->allocations = (double)allocations / iterations;
+    result->tolerance = bench->tolerance;
+}
+
+static void print_result(FILE *f, bench_result_t *result) {
+    fprintf(
+        f,
+        "%s\t%" PRIu64 "\t%.1f\t%.1f\t%.1f\t%.2f\t%.2f\t%.2f\n",
+        result->name,
+        result->iterations,
+        result->median_ns,
+        result->low_ns,
+        result->high_ns,
+        result->mb_per_s,
+        result->allocations,
+        result->tolerance
+    );
+}
+
+static void print_header(FILE *f) {
+    fprintf(f, "benchmark\titerations\tns_per_op\tns_low\tns_high\tmb_per_s\tallocs_per_op\ttolerance\n");
+}
+
+/// @brief Reads the results that were written with '-w', in the same format as the output
+/// @return the number of results, or -1 if the file could not be read
+static int load_baseline(const char *path, bench_result_t *results, size_t max_results) {
+    FILE *f = fopen(path, "r");
+    char line[BENCH_NAME_SIZE * 4];
+    int count = 0;
+
+    if (!f) {
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), f) && (size_t)count < max_results) {
+        bench_result_t *result = &results[count];
+
+        // The header and any lines that are not results are skipped
+        if (sscanf(
+            line,
+            "%63[^\t]\t%" SCNu64 "\t%lf\t%lf\t%lf\t%lf\t%lf\t%lf",
+            result->name,
+            &result->iterations,
+            &result->median_ns,
+            &result->low_ns,
+            &result->high_ns,
+            &result->mb_per_s,
+            &result->allocations,
+            &result->tolerance
+        ) == 8) {
+            count++;
+        }
+    }
+
+    fclose(f);
+    return count;
+}
+
+/// @brief Compares a result to the baseline and reports it
+/// @return false if the benchmark has regressed
+static bool compare_result(bench_result_t *result, bench_result_t *baseline, int baseline_count) {
+    for (int i = 0; i < baseline_count; i++) {
+        if (strcmp(result->name, baseline[i].name) != 0) {
+            continue;
+        }
+
+        // Only a slowdown that is certain, i.e. where even the fast end of the confidence
+        // interval is slower than allowed, is a regression. The allocations are exact.
+        double limit_ns = baseline[i].median_ns * (1 + baseline[i].tolerance);
+        double change = (result->median_ns / baseline[i].median_ns - 1) * 100;
+        bool slower = result->low_ns > limit_ns;
+        bool allocates_more = result->allocations > baseline[i].allocations + 0.5;
+
+        fprintf(
+            stderr,
+            "%-40s %10.1f -> %10.1f ns/op (%+6.1f%%, max %+.0f%%) %6.2f -> %6.2f allocs/op  %s\n",
+            result->name,
+            baseline[i].median_ns,
+            result->median_ns,
+            change,
+            baseline[i].tolerance * 100,
+            baseline[i].allocations,
+            result->allocations,
+            slower ? "SLOWER" : allocates_more ? "MORE ALLOCATIONS" : "ok"
+        );
+        return !slower && !allocates_more;
+    }
+
+    fprintf(stderr, "%-40s %10s -> %10.1f ns/op  not in the baseline\n", result->name, "", result->median_ns);
+    return true;
+}
+
+/// @brief Draws into a terminal that is never shown, the output is thrown away
+static bool initialize_screen() {
+    FILE *out = fopen("/dev/null", "w");
+    FILE *in = fopen("/dev/null", "r");
+
+    // The size of the terminal can not be read from /dev/null
+    setenv("LINES", "30", 1);
+    setenv("COLUMNS", "80", 1);
+
+    if (!out || !in || !newterm("xterm-256color", out, in)) {
+        return false;
+    }
+
+    colors_initialize(true, false);
+    draw_set_backend(DRAW_BACKEND_CURSES);
+    win = newwin(PAGE_LINES, PAGE_COLS, 0, 0);
+
+    for (int i = 0; i < 2 && win; i++) {
+        draw_pages[i] = page_create_empty();
+        html_parser_get_page_tokens(draw_pages[i], html_pages[i].data, html_pages[i].length);
+        draw_pages[i]->id = CACHE_FIRST_PAGE_ID + i;
+    }
+
+    return win && draw_pages[0]->tokens && draw_pages[1]->tokens;
+}
+
+static bool initialize_cache() {
+    cache = cache_create(CACHE_PAGE_COUNT);
+
+    for (int i = 0; i < CACHE_PAGE_COUNT && cache; i++) {
+        page_t *page = page_create_empty();
+        page->id = CACHE_FIRST_PAGE_ID + i;
+
+        if (!cache_put(cache, page)) {
+            page_destroy(page);
+            return false;
+        }
+    }
+
+    return cache != NULL;
+}
+
+static bench_suite_t *add_suite(const char *name) {
+    bench_suite_t *suite = &suites[suite_count];
+    suite->name = name;
+    suite->count = 0;
+    suite_count++;
+    return suite;
+}
+
+static void add_bench(
+    bench_suite_t *suite,
+    const char *name,
+    void (*run)(void *),
+    void *data,
+    size_t bytes,
+    double tolerance
+) {
+    bench_t *bench = &suite->benches[suite->count];
+    snprintf(bench->name, BENCH_NAME_SIZE, "%s", name);
+    bench->run = run;
+    bench->data = data;
+    bench->bytes = bytes;
+    bench->tolerance = tolerance;
+    suite->count++;
+}
+
+static void print_usage() {
+    printf("Usage: ttt_bench [-b <baseline>] [-w <baseline>] [name]\n\n");
+    printf("  -b <baseline>   compare the results to a baseline and fail if any has regressed\n");
+    printf("  -w <baseline>   write the results as a new baseline\n");
+    printf("  name            only run the benchmarks whose name contains it\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *html_paths[HTML_DATA_PAGE_COUNT] = HTML_DATA_PAGE_PATHS;
+    const char *filter = NULL;
+    const char *baseline_path = NULL;
+    const char *output_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (argv[i][0] != '-' && !filter) {
+            filter = argv[i];
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    // A baseline of only some of the benchmarks would hide regressions in the rest
+    if (output_path && filter) {
+        fprintf(stderr, "A baseline is written for every benchmark, it can not be filtered!\n");
+        return 1;
+    }
+
+    bench_result_t baseline[MAX_SUITES * MAX_BENCHES];
+    int baseline_count = 0;
+
+    if (baseline_path) {
+        baseline_count = load_baseline(baseline_path, baseline, MAX_SUITES * MAX_BENCHES);
+
+        if (baseline_count <= 0) {
+            fprintf(stderr, "Failed to read the baseline '%s'!\n", baseline_path);
+            return 1;
+        }
+    }
+
+    bool loaded = load_file(&json_page, JSON_DATA_PAGE_PATH);
+
+    for (int i = 0; i < HTML_DATA_PAGE_COUNT && loaded; i++) {
+        loaded = load_file(&html_pages[i], html_paths[i]);
+    }
+
+    if (
+        !loaded ||
+        !create_synthetic_html(&synthetic_html) ||
+        !create_synthetic_range(&synthetic_range) ||
+        !initialize_cache() ||
+        !initialize_screen()
+    ) {
+        fprintf(stderr, "Failed to set up the benchmarks!\n");
+        return 1;
+    }
+
+    bench_suite_t *parser_suite = add_suite("Page parser benchmarks");
+    bench_suite_t *html_parser_suite = add_suite("HTML parser benchmarks");
+    bench_suite_t *page_suite = add_suite("Page and cache benchmarks");
+    bench_suite_t *render_suite = add_suite("Render benchmarks");
+    char name[BENCH_NAME_SIZE];
+
+    add_bench(parser_suite, "parser_get_page/index", run_parse_page, &json_page, json_page.length, DEFAULT_TOLERANCE);
+    add_bench(
+        parser_suite,
+        "parser_get_page_tokens/index",
+        run_parse_page_with_tokens,
+        &json_page,
+        json_page.length,
+        DEFAULT_TOLERANCE
+    );
+    add_bench(
+        parser_suite,
+        "parser_get_page_collection/synthetic",
+        run_parse_page_collection,
+        &synthetic_range,
+        synthetic_range.length,
+        DEFAULT_TOLERANCE
+    );
+
+    for (int i = 0; i < HTML_DATA_PAGE_COUNT; i++) {
+        snprintf(name, BENCH_NAME_SIZE, "html_parser_get_page_tokens/page%d", i + 1);
+        add_bench(html_parser_suite, name, run_html_tokens, &html_pages[i], html_pages[i].length, DEFAULT_TOLERANCE);
+    }
+
+    add_bench(
+        html_parser_suite,
+        "html_parser_get_page_tokens/synthetic",
+        run_html_tokens,
+        &synthetic_html,
+        synthetic_html.length,
+        DEFAULT_TOLERANCE
+    );
+
+    // The operations that only take a few nanoseconds vary the most between runs
+    add_bench(page_suite, "page_create_destroy", run_page_create_destroy, NULL, 0, NOISY_TOLERANCE);
+    add_bench(page_suite, "cache_get", run_cache_get, NULL, 0, NOISY_TOLERANCE);
+    add_bench(render_suite, "draw_cached/page1-page2", run_draw_cached, NULL, 0, DEFAULT_TOLERANCE);
+    add_bench(render_suite, "draw_cold/page1-page2", run_draw_cold, NULL, 0, DEFAULT_TOLERANCE);
+
+    FILE *output = output_path ? fopen(output_path, "w") : NULL;
+
+    if (output_path && !output) {
+        endwin();
+        fprintf(stderr, "Failed to write the baseline '%s'!\n", output_path);
+        return 1;
+    }
+
+    // The output is tab separated, with a header, so that it can be compared between builds
+    // and used as a baseline. The comparison is reported separately on stderr.
+    print_header(stdout);
+
+    if (output) {
+        print_header(output);
+    }
+
+    int regression_count = 0;
+
+    for (size_t i = 0; i < suite_count; i++) {
+        if (baseline_path) {
+            fprintf(stderr, "%s%s\n", i > 0 ? "\n" : "", suites[i].name);
+        }
+
+        for (size_t j = 0; j < suites[i].count; j++) {
+            bench_t *bench = &suites[i].benches[j];
+            bench_result_t result;
+
+            if (filter && !strstr(bench->name, filter)) {
+                continue;
+            }
+
+            run_bench(bench, &result);
+            print_result(stdout, &result);
+            fflush(stdout);
+
+            if (output) {
+                print_result(output, &result);
+            }
+
+            if (baseline_path && !compare_result(&result, baseline, baseline_count)) {
+                regression_count++;
+            }
+        }
+    }
+
+    endwin();
+
+    if (output && fclose(output) != 0) {
+        fprintf(stderr, "Failed to write the baseline '%s'!\n", output_path);
+        return 1;
+    }
+
+    if (regression_count > 0) {
+        fprintf(stderr, "\n%d benchmark(s) regressed compared to '%s'\n", regression_count, baseline_path);
+        return 1;
+    }
+
+    return 0;
+}
@@ -4,6 +4,19 @@
 #include "../src/pages.h"
 #include "../src/parser.h"
 #include "../src/html_parser.h"
+#include "../src/grid.h"
+#include "../src/events.h"
+#include "../src/cache.h"
+#include "../src/history.h"
+#include "../src/search.h"
+#include "../src/store.h"
+#include "../src/queue.h"
+#include "../src/scheduler.h"
+#include "../src/transitions.h"
+#include "../src/colors.h"
+#include "../src/frame.h"
+#include "../src/ansi.h"
+#include <pthread.h>
 
 #define JSON_DATA_PAGE_PATH "./test/data/index.json"
 #define HTML_DATA_PAGE_1_PATH "./test/data/page1.html"
@@ -21,6 +34,8 @@ static file_data_t JSON_DATA_PAGE;
 static file_data_t HTML_DATA_PAGE_1;
 static file_data_t HTML_DATA_PAGE_2;
 static file_data_t HTML_DATA_PAGE_3;
+static FILE *terminal_file = NULL;
+static SCREEN *terminal_screen = NULL;
 
 bool load_test_data(file_data_t *dest, const char *path) {
     FILE *f = fopen(path, "r");
@@ -48,6 +63,20 @@ void destroy_test_data(file_data_t *json) {
     free(json->data);
 }
 
+/// @brief Starts curses with a terminal of the type that writes to /dev/null,
+///        for the tests of the code that depends on the capabilities of the terminal
+bool start_test_terminal(const char *type) {
+    terminal_file = fopen("/dev/null", "r+");
+    terminal_screen = terminal_file ? newterm(type, terminal_file, terminal_file) : NULL;
+    return terminal_screen != NULL;
+}
+
+void stop_test_terminal() {
+    endwin();
+    delscreen(terminal_screen);
+    fclose(terminal_file);
+}
+
 void assert_page_collection(page_collection_t *collection, size_t size) {
     CU_ASSERT_EQUAL(collection->size, size);
 
@@ -102,9 +131,9 @@ void assert_parsed_page(
     }
 
     if (!has_tokens) {
-        CU_ASSERT_PTR_NULL(page->tokens);
+        CU_ASSERT_PTR_NULL(page_get_tokens(page));
     } else {
-        CU_ASSERT_PTR_NOT_NULL(page->tokens);
+        CU_ASSERT_PTR_NOT_NULL(page_get_tokens(page));
     }
 }
 
@@ -260,9 +289,7 @@ void test_page_invalid_keys() {
 void test_page_large_content_array() {
     char *str = "[{\"content\": [\"xxx\", \"yyy\", \"zzz\"]}]";
     page_t *page = parser_get_page(str, strlen(str));
-
-    // The content strings are invalid html and won't be parsed correctly
-    CU_ASSERT_TRUE(error_is_set());
+    CU_ASSERT_FALSE(error_is_set());
 
     assert_parsed_page(
         page,
@@ -274,6 +301,9 @@ void test_page_large_content_array() {
         false
     );
 
+    // The content strings are invalid html and won't be parsed correctly once they are used
+    CU_ASSERT_TRUE(error_is_set());
+
     page_destroy(page);
     error_reset();
 }
@@ -308,6 +338,46 @@ void test_page_collection_empty_objects() {
     error_reset();
 }
 
+void test_page_collection_range() {
+    // Nested values in unknown keys must not be mistaken for page keys
+    char *str = "[{\"num\":\"330\",\"extra\":{\"num\":\"1\",\"list\":[1,[2]]},\"title\":\"A\"},\
+                 \"xxx\", {}, {\"num\":\"331\",\"next_page\":\"332\",\"title\":\"B\"}]";
+    page_collection_t *collection = parser_get_page_collection(str, strlen(str));
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(collection);
+    CU_ASSERT_EQUAL_FATAL(collection->size, 2);
+    assert_parsed_page(collection->pages[0], 330, -1, -1, -1, "A", false);
+    assert_parsed_page(collection->pages[1], 331, -1, 332, -1, "B", false);
+
+    page_collection_destroy(collection);
+    error_reset();
+}
+
+void test_page_sources() {
+    char *str = "[{\"num\":\"330\",\"extra\":[{}]}, \"xxx\", {\"num\":\"331\"}]";
+    parser_source_t sources[4];
+
+    CU_ASSERT_EQUAL_FATAL(parser_get_page_sources(str, strlen(str), sources, 4), 2);
+    CU_ASSERT_EQUAL(sources[0].data, str + 1);
+    CU_ASSERT_EQUAL(sources[0].size, strlen("{\"num\":\"330\",\"extra\":[{}]}"));
+    CU_ASSERT_EQUAL(strncmp(sources[1].data, "{\"num\":\"331\"}", sources[1].size), 0);
+
+    // There is only room for the first page
+    CU_ASSERT_EQUAL(parser_get_page_sources(str, strlen(str), sources, 1), 1);
+    error_reset();
+}
+
+void test_page_collection_invalid() {
+    char *str = "{\"num\":\"330\"}";
+    CU_ASSERT_PTR_NULL(parser_get_page_collection(str, strlen(str)));
+    CU_ASSERT_TRUE(error_is_set());
+    error_reset();
+
+    CU_ASSERT_PTR_NULL(parser_get_page_collection("[{", 2));
+    CU_ASSERT_TRUE(error_is_set());
+    error_reset();
+}
+
 void test_page_single() {
     page_t *page = parser_get_page(
         JSON_DATA_PAGE.data, JSON_DATA_PAGE.length
@@ -315,6 +385,11 @@ void test_page_single() {
 
     CU_ASSERT_FALSE(error_is_set());
 
+    // Only the metadata is parsed until the tokens are needed
+    CU_ASSERT_PTR_NOT_NULL_FATAL(page);
+    CU_ASSERT_PTR_NULL(page->tokens);
+    CU_ASSERT_PTR_NOT_NULL(page->content);
+
     assert_parsed_page(
         page,
         200,
@@ -325,6 +400,8 @@ void test_page_single() {
         true
     );
 
+    CU_ASSERT_FALSE(error_is_set());
+    CU_ASSERT_PTR_NULL(page->content);
     page_destroy(page);
     error_reset();
 }
@@ -985,6 +1062,1066 @@ void test_page_html_3() {
     error_reset();
 }
 
+void test_grid_empty_page() {
+    page_t *page = page_create_empty();
+    page_grid_t *grid = grid_get(page);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(grid);
+    CU_ASSERT_PTR_EQUAL(grid, page->grid);
+
+    for (int line = 0; line < PAGE_LINES; line++) {
+        for (int col = 0; col < PAGE_COLS; col++) {
+            CU_ASSERT_EQUAL(grid->cells[line][col].glyph, GRID_CELL_EMPTY_GLYPH);
+            CU_ASSERT_PTR_NULL(grid->cells[line][col].token);
+        }
+
+        CU_ASSERT_EQUAL(grid_get_row_hash(grid, line), grid_get_row_hash(grid, 0));
+    }
+
+    page_destroy(page);
+    error_reset();
+}
+
+void test_grid_line_wrap() {
+    // 45 characters, i.e. the last 5 should wrap to the next line
+    const char *str = "<span class=\"Y\">0123456789012345678901234567890123456789abcde</span>";
+    page_t *page = page_create_empty();
+    html_parser_get_page_tokens(page, str, strlen(str));
+
+    assert_parsed_page_tokens(page);
+
+    page_grid_t *grid = grid_get(page);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(grid);
+
+    char buf[PAGE_COLS + 1];
+    grid_get_row_text(grid, 0, buf, sizeof(buf));
+    assert_string_value(buf, "0123456789012345678901234567890123456789");
+    grid_get_row_text(grid, 1, buf, sizeof(buf));
+    assert_string_value(buf, "abcde                                   ");
+
+    CU_ASSERT_PTR_EQUAL(grid_get_cell(grid, 1, 4)->token, page->tokens);
+    CU_ASSERT_PTR_NULL(grid_get_cell(grid, 1, 5)->token);
+    CU_ASSERT_PTR_NULL(grid_get_cell(grid, PAGE_LINES, 0));
+    CU_ASSERT_NOT_EQUAL(grid_get_row_hash(grid, 0), grid_get_row_hash(grid, 1));
+    CU_ASSERT_EQUAL(grid_get_row_hash(grid, 2), grid_get_row_hash(grid, PAGE_LINES - 1));
+
+    page_destroy(page);
+    error_reset();
+}
+
+void test_grid_rows_equal_style() {
+    const char *yellow = "<span class=\"Y\">hello</span>";
+    const char *red = "<span class=\"R\">hello</span>";
+    page_t *page = page_create_empty();
+    page_t *other = page_create_empty();
+    page_t *same = page_create_empty();
+    html_parser_get_page_tokens(page, yellow, strlen(yellow));
+    html_parser_get_page_tokens(other, red, strlen(red));
+    html_parser_get_page_tokens(same, yellow, strlen(yellow));
+
+    // Same text, but different colors
+    CU_ASSERT_FALSE(grid_rows_equal(grid_get(page), 0, grid_get(other), 0));
+    CU_ASSERT_TRUE(grid_rows_equal(grid_get(page), 0, grid_get(same), 0));
+    CU_ASSERT_TRUE(grid_rows_equal(grid_get(page), 1, grid_get(other), 1));
+
+    page_destroy(page);
+    page_destroy(other);
+    page_destroy(same);
+    error_reset();
+}
+
+void test_grid_html_1() {
+    page_t *page = page_create_empty();
+    html_parser_get_page_tokens(page, HTML_DATA_PAGE_1.data, HTML_DATA_PAGE_1.length);
+
+    assert_parsed_page_tokens(page);
+
+    page_grid_t *grid = grid_get(page);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(grid);
+
+    char buf[PAGE_COLS + 1];
+    grid_get_row_text(grid, 0, buf, sizeof(buf));
+    assert_string_value(buf, " 700 SVT Text        Torsdag 28 jan 2021");
+    CU_ASSERT_EQUAL(grid_get_cell(grid, 0, 0)->token->type, PAGE_TOKEN_HEADER);
+    CU_ASSERT_EQUAL(grid_get_cell(grid, 1, 1)->token->style.bg, PAGE_TOKEN_ATTR_BG_YELLOW);
+
+    page_destroy(page);
+    error_reset();
+}
+
+void test_grid_links() {
+    // Two links on the first line and one on the second line
+    const char *str = "<span class=\"Y\"><a href=\"/101\">101</a>     <a href=\"/102\">102</a></span>\\n"
+                      "<span class=\"Y\">                                             <a href=\"/103\">103</a></span>";
+    page_t *page = page_create_empty();
+    html_parser_get_page_tokens(page, str, strlen(str));
+
+    assert_parsed_page_tokens(page);
+
+    page_grid_t *grid = grid_get(page);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(grid);
+    CU_ASSERT_EQUAL_FATAL(grid->link_count, 3);
+
+    page_link_t *link = grid_get_link(grid, 2);
+    CU_ASSERT_EQUAL(link->href, 103);
+    CU_ASSERT_EQUAL(link->line, 1);
+    CU_ASSERT_EQUAL(link->col, 16);
+    CU_ASSERT_EQUAL(link->length, 3);
+
+    CU_ASSERT_EQUAL(grid_get_link_at(grid, 0, 0), 0);
+    CU_ASSERT_EQUAL(grid_get_link_at(grid, 0, 10), 1);
+    CU_ASSERT_EQUAL(grid_get_link_at(grid, 1, 16), 2);
+    CU_ASSERT_EQUAL(grid_get_link_at(grid, 0, 5), GRID_NO_LINK);
+    CU_ASSERT_PTR_NULL(grid_get_link(grid, 3));
+
+    // The second link is closer to the link below
+    CU_ASSERT_EQUAL(grid_get_link_neighbour(grid, 2, LINK_DIRECTION_UP), 1);
+    CU_ASSERT_EQUAL(grid_get_link_neighbour(grid, 0, LINK_DIRECTION_DOWN), 2);
+    CU_ASSERT_EQUAL(grid_get_link_neighbour(grid, 0, LINK_DIRECTION_RIGHT), 1);
+    CU_ASSERT_EQUAL(grid_get_link_neighbour(grid, 1, LINK_DIRECTION_LEFT), 0);
+    CU_ASSERT_EQUAL(grid_get_link_neighbour(grid, 0, LINK_DIRECTION_UP), GRID_NO_LINK);
+    CU_ASSERT_EQUAL(grid_get_link_neighbour(grid, 2, LINK_DIRECTION_DOWN), GRID_NO_LINK);
+    // Left and right stay on the same line
+    CU_ASSERT_EQUAL(grid_get_link_neighbour(grid, 1, LINK_DIRECTION_RIGHT), GRID_NO_LINK);
+    CU_ASSERT_EQUAL(grid_get_link_neighbour(grid, 2, LINK_DIRECTION_LEFT), GRID_NO_LINK);
+
+    page_destroy(page);
+    error_reset();
+}
+
+void test_grid_many_links() {
+    // Index pages can contain a lot more links than we used to keep track of
+    char str[4096] = "<span class=\"Y\">";
+
+    for (int i = 0; i < 100; i++) {
+        strcat(str, "<a href=\"/100\">100</a> ");
+    }
+
+    strcat(str, "</span>");
+    page_t *page = page_create_empty();
+    html_parser_get_page_tokens(page, str, strlen(str));
+
+    assert_parsed_page_tokens(page);
+
+    page_grid_t *grid = grid_get(page);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(grid);
+    CU_ASSERT_EQUAL(grid->link_count, 100);
+    CU_ASSERT_EQUAL(grid_get_link(grid, 99)->line, 9);
+
+    page_destroy(page);
+    error_reset();
+}
+
+static int timer_expirations = 0;
+
+static void count_timer_and_stop(void *data) {
+    timer_expirations++;
+
+    if (timer_expirations == *(int *)data) {
+        events_stop();
+    }
+}
+
+static void read_pipe_and_stop(void *data) {
+    char c;
+    int *fds = data;
+    CU_ASSERT_EQUAL(read(fds[0], &c, 1), 1);
+    CU_ASSERT_EQUAL(c, 'x');
+    events_stop();
+}
+
+void test_events_timer() {
+    int expected = 3;
+    timer_expirations = 0;
+    CU_ASSERT_TRUE_FATAL(events_initialize());
+
+    int timer = events_add_timer(count_timer_and_stop, &expected);
+    CU_ASSERT_NOT_EQUAL_FATAL(timer, EVENTS_INVALID_SOURCE);
+
+    events_set_timer(timer, 1, 1);
+    events_run();
+    CU_ASSERT_EQUAL(timer_expirations, expected);
+
+    events_destroy();
+}
+
+void test_events_fd() {
+    int fds[2];
+    CU_ASSERT_EQUAL_FATAL(pipe(fds), 0);
+    CU_ASSERT_TRUE_FATAL(events_initialize());
+
+    int source = events_add_fd(fds[0], read_pipe_and_stop, fds);
+    CU_ASSERT_NOT_EQUAL_FATAL(source, EVENTS_INVALID_SOURCE);
+    CU_ASSERT_EQUAL(events_add_fd(-1, read_pipe_and_stop, NULL), EVENTS_INVALID_SOURCE);
+
+    CU_ASSERT_EQUAL(write(fds[1], "x", 1), 1);
+    events_run();
+
+    events_destroy();
+    close(fds[0]);
+    close(fds[1]);
+}
+
+static page_t *create_page_with_id(uint16_t id) {
+    page_t *page = page_create_empty();
+    page->id = id;
+    return page;
+}
+
+void test_cache_get() {
+    page_cache_t *cache = cache_create(4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(cache);
+
+    page_t *page = create_page_with_id(100);
+    CU_ASSERT_TRUE(cache_put(cache, page));
+    CU_ASSERT_PTR_EQUAL(cache_get(cache, 100), page);
+    CU_ASSERT_TRUE(cache_contains(cache, 100));
+    CU_ASSERT_PTR_EQUAL(cache_peek(cache, 100), page);
+    CU_ASSERT_PTR_NULL(cache_get(cache, 101));
+    CU_ASSERT_PTR_NULL(cache_peek(cache, 101));
+    CU_ASSERT_FALSE(cache_contains(cache, 101));
+
+    // Pages without a valid id are not cached
+    page_t *empty = page_create_empty();
+    CU_ASSERT_FALSE(cache_put(cache, empty));
+    CU_ASSERT_EQUAL(cache_get_size(cache), 1);
+    page_destroy(empty);
+
+    cache_destroy(cache);
+}
+
+void test_cache_replace() {
+    page_cache_t *cache = cache_create(4);
+    page_t *old_page = create_page_with_id(330);
+    page_t *new_page = create_page_with_id(330);
+
+    CU_ASSERT_TRUE(cache_put(cache, old_page));
+    cache_pin(cache, old_page);
+    CU_ASSERT_TRUE(cache_put(cache, new_page));
+
+    // The old page is kept until it has been unpinned
+    CU_ASSERT_PTR_EQUAL(cache_get(cache, 330), new_page);
+    CU_ASSERT_EQUAL(cache_get_size(cache), 1);
+    CU_ASSERT_EQUAL(old_page->id, 330);
+    cache_unpin(cache, old_page);
+    CU_ASSERT_PTR_EQUAL(cache_get(cache, 330), new_page);
+
+    cache_destroy(cache);
+}
+
+void test_cache_eviction() {
+    page_cache_t *cache = cache_create(2);
+    page_t *first = create_page_with_id(100);
+    page_t *second = create_page_with_id(101);
+
+    cache_put(cache, first);
+    cache_put(cache, second);
+    cache_pin(cache, first);
+    // The first page is the least recently used, but it is pinned
+    cache_put(cache, create_page_with_id(102));
+
+    CU_ASSERT_EQUAL(cache_get_size(cache), 2);
+    CU_ASSERT_PTR_EQUAL(cache_get(cache, 100), first);
+    CU_ASSERT_FALSE(cache_contains(cache, 101));
+    CU_ASSERT_TRUE(cache_contains(cache, 102));
+
+    // Everything else is pinned, so the cache has to grow
+    cache_pin(cache, cache_get(cache, 102));
+    cache_put(cache, create_page_with_id(103));
+    CU_ASSERT_EQUAL(cache_get_size(cache), 3);
+    CU_ASSERT_TRUE(cache_contains(cache, 103));
+
+    // Until a page is unpinned
+    cache_unpin(cache, first);
+    CU_ASSERT_EQUAL(cache_get_size(cache), 2);
+    CU_ASSERT_FALSE(cache_contains(cache, 100));
+    CU_ASSERT_TRUE(cache_contains(cache, 102));
+    CU_ASSERT_TRUE(cache_contains(cache, 103));
+
+    cache_destroy(cache);
+}
+
+void test_history_back_forward() {
+    page_cache_t *cache = cache_create(4);
+    history_t *history = history_create(cache, 4);
+    page_t *first = create_page_with_id(100);
+    page_t *second = create_page_with_id(200);
+    cache_put(cache, first);
+    cache_put(cache, second);
+
+    CU_ASSERT_PTR_NULL(history_back(history));
+    history_push(history, first);
+    history_set_state(history, 3, NULL);
+    history_push(history, second);
+
+    history_entry_t *entry = history_back(history);
+    CU_ASSERT_PTR_EQUAL(entry->page, first);
+    CU_ASSERT_EQUAL(entry->link_index, 3);
+    CU_ASSERT_PTR_NULL(history_back(history));
+
+    entry = history_forward(history);
+    CU_ASSERT_PTR_EQUAL(entry->page, second);
+    CU_ASSERT_EQUAL(entry->link_index, -1);
+    CU_ASSERT_PTR_NULL(history_forward(history));
+
+    // Visiting a page after going back forgets the pages ahead
+    history_back(history);
+    history_push(history, second);
+    CU_ASSERT_EQUAL(history_get_size(history), 2);
+    CU_ASSERT_PTR_NULL(history_forward(history));
+
+    history_destroy(history);
+    cache_destroy(cache);
+}
+
+void test_history_pins_pages() {
+    page_cache_t *cache = cache_create(1);
+    history_t *history = history_create(cache, 2);
+    page_t *first = create_page_with_id(100);
+    page_t *second = create_page_with_id(101);
+    page_t *third = create_page_with_id(102);
+
+    cache_put(cache, first);
+    history_push(history, first);
+    cache_put(cache, second);
+    history_push(history, second);
+
+    // Both pages are in the history, so neither can be evicted
+    CU_ASSERT_TRUE(cache_contains(cache, 100));
+    CU_ASSERT_TRUE(cache_contains(cache, 101));
+
+    // The oldest page is forgotten when the history is full
+    cache_put(cache, third);
+    history_push(history, third);
+    CU_ASSERT_EQUAL(history_get_size(history), 2);
+    CU_ASSERT_PTR_EQUAL(history_back(history)->page, second);
+    CU_ASSERT_PTR_NULL(history_back(history));
+    CU_ASSERT_FALSE(cache_contains(cache, 100));
+
+    history_destroy(history);
+    cache_destroy(cache);
+}
+
+void test_history_replace_current() {
+    page_cache_t *cache = cache_create(4);
+    history_t *history = history_create(cache, 4);
+    page_t *old_page = create_page_with_id(330);
+    page_t *new_page = create_page_with_id(330);
+
+    cache_put(cache, old_page);
+    history_push(history, old_page);
+    cache_put(cache, new_page);
+    // The old page is pinned by the history, so it is kept until it has been replaced
+    CU_ASSERT_EQUAL(old_page->id, 330);
+    history_replace_current(history, new_page);
+
+    CU_ASSERT_PTR_EQUAL(history_get_current(history)->page, new_page);
+    CU_ASSERT_PTR_EQUAL(cache_get(cache, 330), new_page);
+
+    history_destroy(history);
+    cache_destroy(cache);
+}
+
+static page_t *create_page_with_text(uint16_t id, const char *text) {
+    page_t *page = create_page_with_id(id);
+    page_token_t *token = page_token_create_empty();
+    token->text = malloc(strlen(text) + 1);
+    strcpy(token->text, text);
+    page_token_append(page, token, false);
+    return page;
+}
+
+void test_search_query() {
+    search_index_t *index = search_create();
+    search_hit_t hits[4];
+    page_t *first = create_page_with_text(330, "Djurgarden - AIK 2-1, Djurgarden vann");
+    page_t *second = create_page_with_text(376, "AIK:s tranare om Djurgardens seger");
+
+    CU_ASSERT_TRUE(search_add_page(index, first));
+    CU_ASSERT_TRUE(search_add_page(index, second));
+    CU_ASSERT_EQUAL(search_get_page_count(index), 2);
+
+    // Whole words rank higher than words that only start with the query
+    CU_ASSERT_EQUAL(search_query(index, "djurgarden", hits, 4), 2);
+    CU_ASSERT_EQUAL(hits[0].page_id, 330);
+    CU_ASSERT_EQUAL(hits[1].page_id, 376);
+
+    // Every word has to be on the page, in any case
+    CU_ASSERT_EQUAL(search_query(index, "aik TRANARE", hits, 4), 1);
+    CU_ASSERT_EQUAL(hits[0].page_id, 376);
+    CU_ASSERT_EQUAL(search_query(index, "hammarby", hits, 4), 0);
+    CU_ASSERT_EQUAL(search_query(index, " - ", hits, 4), 0);
+
+    page_destroy(first);
+    page_destroy(second);
+    search_destroy(index);
+}
+
+void test_search_reindex() {
+    search_index_t *index = search_create();
+    search_hit_t hits[4];
+    page_t *old_page = create_page_with_text(330, "Stockholmsborsen stiger");
+    page_t *new_page = create_page_with_text(330, "Stockholmsborsen faller");
+
+    search_add_page(index, old_page);
+    search_add_page(index, new_page);
+
+    // The words of the old version of the page are removed
+    CU_ASSERT_EQUAL(search_get_page_count(index), 1);
+    CU_ASSERT_EQUAL(search_query(index, "stiger", hits, 4), 0);
+    CU_ASSERT_EQUAL(search_query(index, "faller", hits, 4), 1);
+
+    search_remove_page(index, 330);
+    CU_ASSERT_FALSE(search_contains_page(index, 330));
+    CU_ASSERT_EQUAL(search_query(index, "stockholmsborsen", hits, 4), 0);
+
+    page_destroy(old_page);
+    page_destroy(new_page);
+    search_destroy(index);
+}
+
+void test_store_pages() {
+    char path[] = "/tmp/ttt_tests_XXXXXX";
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(path));
+    page_store_t *store = store_open(path);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(store);
+
+    char *source = "{\"num\":\"330\",\"title\":\"Stored\"}";
+    CU_ASSERT_FALSE(store_contains(store, 330));
+    CU_ASSERT_PTR_NULL(store_get_page(store, 330, NULL));
+    // A page that has not been stored is not an error
+    CU_ASSERT_FALSE(error_is_set());
+
+    CU_ASSERT_TRUE(store_put(store, 330, source, strlen(source)));
+    CU_ASSERT_TRUE(store_contains(store, 330));
+
+    time_t stored_at = 0;
+    page_t *page = store_get_page(store, 330, &stored_at);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(page);
+    CU_ASSERT_EQUAL(page->id, 330);
+    CU_ASSERT_STRING_EQUAL(page->title, "Stored");
+    CU_ASSERT_TRUE(stored_at > 0);
+    page_destroy(page);
+
+    store_remove(store, 330);
+    CU_ASSERT_FALSE(store_contains(store, 330));
+    store_close(store);
+    rmdir(path);
+    error_reset();
+}
+
+void test_store_range() {
+    char path[] = "/tmp/ttt_tests_XXXXXX";
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(path));
+    page_store_t *store = store_open(path);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(store);
+
+    // Two subpages of 330, and a page outside of the range
+    char *data = "[{\"num\":\"330\",\"title\":\"First\"},{\"num\":\"330\",\"title\":\"Second\"},"
+                 "{\"num\":\"331\"},{\"num\":\"400\"}]";
+    page_collection_t *pages = store_put_range(store, 330, 331, data, strlen(data));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(pages);
+    CU_ASSERT_EQUAL_FATAL(pages->size, 2);
+    CU_ASSERT_EQUAL(pages->pages[0]->id, 330);
+    CU_ASSERT_EQUAL(pages->pages[1]->id, 331);
+    page_collection_destroy(pages);
+
+    page_t *page = store_get_page(store, 330, NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(page);
+    CU_ASSERT_STRING_EQUAL(page->title, "First");
+    page_destroy(page);
+    CU_ASSERT_FALSE(store_contains(store, 400));
+
+    store_remove(store, 330);
+    store_remove(store, 331);
+    store_close(store);
+    rmdir(path);
+    error_reset();
+}
+
+void test_store_last_page() {
+    char path[] = "/tmp/ttt_tests_XXXXXX";
+    char file_path[sizeof(path) + sizeof(STORE_LAST_PAGE_FILE_NAME)];
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(path));
+    page_store_t *store = store_open(path);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(store);
+
+    CU_ASSERT_EQUAL(store_get_last_page(store), 0);
+    CU_ASSERT_TRUE(store_set_last_page(store, 377));
+    CU_ASSERT_EQUAL(store_get_last_page(store), 377);
+    CU_ASSERT_TRUE(store_set_last_page(store, 100));
+    CU_ASSERT_EQUAL(store_get_last_page(store), 100);
+
+    snprintf(file_path, sizeof(file_path), "%s/%s", path, STORE_LAST_PAGE_FILE_NAME);
+    remove(file_path);
+    store_close(store);
+    rmdir(path);
+}
+
+void test_transitions_predict() {
+    transition_model_t *model = transitions_create();
+    uint16_t ids[3];
+    CU_ASSERT_PTR_NOT_NULL_FATAL(model);
+    CU_ASSERT_EQUAL(transitions_predict(model, 100, ids, 3, 0), 0);
+
+    for (int i = 0; i < 3; i++) {
+        transitions_record(model, 100, 104);
+    }
+
+    transitions_record(model, 100, 101);
+    transitions_record(model, 100, 101);
+    transitions_record(model, 100, 330);
+    // Reloading a page is not a transition
+    transitions_record(model, 100, 100);
+    CU_ASSERT_EQUAL(transitions_get_count(model, 100), 6);
+
+    CU_ASSERT_EQUAL_FATAL(transitions_predict(model, 100, ids, 3, 0), 3);
+    CU_ASSERT_EQUAL(ids[0], 104);
+    CU_ASSERT_EQUAL(ids[1], 101);
+    CU_ASSERT_EQUAL(ids[2], 330);
+
+    // Only the pages that are likely enough are predicted
+    CU_ASSERT_EQUAL(transitions_predict(model, 100, ids, 3, 0.3), 2);
+    CU_ASSERT_EQUAL(transitions_predict(model, 100, ids, 1, 0), 1);
+    CU_ASSERT_EQUAL(transitions_predict(model, 101, ids, 3, 0), 0);
+
+    // The least common page is replaced when every one is used
+    for (int i = 0; i < TRANSITIONS_PER_PAGE; i++) {
+        transitions_record(model, 300, 301 + i);
+        transitions_record(model, 300, 301 + i);
+    }
+
+    transitions_record(model, 300, 301);
+    transitions_record(model, 300, 400);
+    uint16_t next[TRANSITIONS_PER_PAGE];
+    CU_ASSERT_EQUAL_FATAL(transitions_predict(model, 300, next, TRANSITIONS_PER_PAGE, 0), TRANSITIONS_PER_PAGE);
+    CU_ASSERT_EQUAL(next[0], 301);
+    CU_ASSERT_EQUAL(next[TRANSITIONS_PER_PAGE - 1], 400);
+    transitions_destroy(model);
+}
+
+void test_transitions_persist() {
+    char path[] = "/tmp/ttt_tests_XXXXXX";
+    char file_path[sizeof(path) + sizeof(TRANSITIONS_FILE_NAME)];
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(path));
+    snprintf(file_path, sizeof(file_path), "%s/%s", path, TRANSITIONS_FILE_NAME);
+
+    transition_model_t *model = transitions_create();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(model);
+    // A model that has not been saved is not an error
+    CU_ASSERT_TRUE(transitions_load(model, file_path));
+    CU_ASSERT_FALSE(error_is_set());
+
+    transitions_record(model, 300, 330);
+    transitions_record(model, 330, 376);
+    transitions_record(model, 330, 376);
+    CU_ASSERT_TRUE(transitions_save(model, file_path));
+    transitions_destroy(model);
+
+    uint16_t ids[2];
+    model = transitions_create();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(model);
+    CU_ASSERT_TRUE(transitions_load(model, file_path));
+    CU_ASSERT_EQUAL_FATAL(transitions_predict(model, 330, ids, 2, 0), 1);
+    CU_ASSERT_EQUAL(ids[0], 376);
+    CU_ASSERT_EQUAL(transitions_get_count(model, 330), 2);
+    CU_ASSERT_EQUAL(transitions_get_count(model, 300), 1);
+
+    // Files that are not models are ignored
+    FILE *file = fopen(file_path, "w");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+    fputs("[]", file);
+    fclose(file);
+    CU_ASSERT_FALSE(transitions_load(model, file_path));
+    CU_ASSERT_EQUAL(error_get(), TTT_ERROR_STORE_FAILED);
+    CU_ASSERT_EQUAL(transitions_get_count(model, 330), 0);
+
+    transitions_destroy(model);
+    remove(file_path);
+    rmdir(path);
+    error_reset();
+}
+
+#define QUEUE_TEST_THREADS 4
+#define QUEUE_TEST_ITEMS 1000
+
+typedef struct queue_test_item {
+    queue_node_t node;
+    int thread;
+    int number;
+} queue_test_item_t;
+
+typedef struct queue_test_thread {
+    queue_t *queue;
+    queue_test_item_t *items;
+    int thread;
+} queue_test_thread_t;
+
+static void *push_queue_test_items(void *data) {
+    queue_test_thread_t *thread = data;
+
+    for (int i = 0; i < QUEUE_TEST_ITEMS; i++) {
+        thread->items[i].thread = thread->thread;
+        thread->items[i].number = i;
+        queue_push(thread->queue, &thread->items[i].node);
+    }
+
+    return NULL;
+}
+
+void test_queue_order() {
+    queue_t queue;
+    queue_test_item_t items[3];
+    queue_initialize(&queue);
+    CU_ASSERT_TRUE(queue_is_empty(&queue));
+    CU_ASSERT_PTR_NULL(queue_take_all(&queue));
+
+    // Only the first push has to wake up the consumer
+    CU_ASSERT_TRUE(queue_push(&queue, &items[0].node));
+    CU_ASSERT_FALSE(queue_push(&queue, &items[1].node));
+    CU_ASSERT_FALSE(queue_push(&queue, &items[2].node));
+
+    queue_node_t *node = queue_take_all(&queue);
+    CU_ASSERT_TRUE(queue_is_empty(&queue));
+    CU_ASSERT_PTR_EQUAL(node, &items[0].node);
+    CU_ASSERT_PTR_EQUAL(node->next, &items[1].node);
+    CU_ASSERT_PTR_EQUAL(node->next->next, &items[2].node);
+    CU_ASSERT_PTR_NULL(node->next->next->next);
+}
+
+void test_queue_threads() {
+    queue_t queue;
+    pthread_t threads[QUEUE_TEST_THREADS];
+    queue_test_thread_t data[QUEUE_TEST_THREADS];
+    static queue_test_item_t items[QUEUE_TEST_THREADS][QUEUE_TEST_ITEMS];
+    int next_numbers[QUEUE_TEST_THREADS] = {0};
+    int count = 0;
+    queue_initialize(&queue);
+
+    for (int i = 0; i < QUEUE_TEST_THREADS; i++) {
+        data[i].queue = &queue;
+        data[i].items = items[i];
+        data[i].thread = i;
+        CU_ASSERT_EQUAL_FATAL(pthread_create(&threads[i], NULL, push_queue_test_items, &data[i]), 0);
+    }
+
+    // Take the items while they are being pushed
+    while (count < QUEUE_TEST_THREADS * QUEUE_TEST_ITEMS) {
+        queue_node_t *node = queue_take_all(&queue);
+
+        while (node) {
+            queue_test_item_t *item = (queue_test_item_t *)node;
+            // The items of every thread are taken in the order they were pushed
+            CU_ASSERT_EQUAL(item->number, next_numbers[item->thread]);
+            next_numbers[item->thread] = item->number + 1;
+            node = node->next;
+            count++;
+        }
+    }
+
+    for (int i = 0; i < QUEUE_TEST_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    CU_ASSERT_TRUE(queue_is_empty(&queue));
+}
+
+void test_scheduler_priority() {
+    scheduler_t scheduler;
+    scheduler_entry_t prefetch, crawl, visible, typed;
+    uint64_t wait_ms;
+    scheduler_initialize(&scheduler, 4, 1000, 100);
+    scheduler_add(&scheduler, &prefetch, SCHEDULER_PRIORITY_PREFETCH);
+    scheduler_add(&scheduler, &crawl, SCHEDULER_PRIORITY_CRAWL);
+    scheduler_add(&scheduler, &visible, SCHEDULER_PRIORITY_VISIBLE);
+    scheduler_add(&scheduler, &typed, SCHEDULER_PRIORITY_TYPED);
+
+    CU_ASSERT_PTR_EQUAL(scheduler_take(&scheduler, 0, &wait_ms), &visible);
+    CU_ASSERT_PTR_EQUAL(scheduler_take(&scheduler, 0, &wait_ms), &typed);
+    CU_ASSERT_PTR_EQUAL(scheduler_take(&scheduler, 0, &wait_ms), &prefetch);
+    CU_ASSERT_FALSE(typed.waiting);
+
+    // Crawling waits until the page that the user is waiting for has been fetched
+    CU_ASSERT_PTR_NULL(scheduler_take(&scheduler, 0, &wait_ms));
+    CU_ASSERT_EQUAL(wait_ms, 0);
+    CU_ASSERT_TRUE(crawl.waiting);
+    scheduler_finish(&scheduler, &visible);
+    CU_ASSERT_PTR_EQUAL(scheduler_take(&scheduler, 0, &wait_ms), &crawl);
+}
+
+void test_scheduler_limits() {
+    scheduler_t scheduler;
+    scheduler_entry_t prefetch[3], typed[2], visible;
+    uint64_t wait_ms;
+    scheduler_initialize(&scheduler, 4, 1000, 100);
+
+    for (int i = 0; i < 3; i++) {
+        scheduler_add(&scheduler, &prefetch[i], SCHEDULER_PRIORITY_PREFETCH);
+    }
+
+    CU_ASSERT_PTR_EQUAL(scheduler_take(&scheduler, 0, &wait_ms), &prefetch[0]);
+    CU_ASSERT_PTR_EQUAL(scheduler_take(&scheduler, 0, &wait_ms), &prefetch[1]);
+    CU_ASSERT_PTR_NULL(scheduler_take(&scheduler, 0, &wait_ms));
+
+    // The last slot is left for the page that the user is waiting for
+    scheduler_add(&scheduler, &typed[0], SCHEDULER_PRIORITY_TYPED);
+    scheduler_add(&scheduler, &typed[1], SCHEDULER_PRIORITY_TYPED);
+    CU_ASSERT_PTR_EQUAL(scheduler_take(&scheduler, 0, &wait_ms), &typed[0]);
+    CU_ASSERT_PTR_NULL(scheduler_take(&scheduler, 0, &wait_ms));
+
+    scheduler_add(&scheduler, &visible, SCHEDULER_PRIORITY_VISIBLE);
+    CU_ASSERT_PTR_EQUAL(scheduler_take(&scheduler, 0, &wait_ms), &visible);
+
+    // A prefetch of the page that the user navigates to runs right away
+    scheduler_promote(&scheduler, &prefetch[2], SCHEDULER_PRIORITY_VISIBLE);
+    CU_ASSERT_PTR_EQUAL(scheduler_take(&scheduler, 0, &wait_ms), &prefetch[2]);
+    CU_ASSERT_EQUAL(scheduler.running[SCHEDULER_PRIORITY_VISIBLE], 2);
+
+    // Taken entries keep their slot, but are counted with their new priority
+    scheduler_promote(&scheduler, &typed[0], SCHEDULER_PRIORITY_VISIBLE);
+    CU_ASSERT_EQUAL(scheduler.running[SCHEDULER_PRIORITY_VISIBLE], 3);
+    CU_ASSERT_PTR_EQUAL(scheduler_take(&scheduler, 0, &wait_ms), &typed[1]);
+}
+
+void test_scheduler_rate_limit() {
+    scheduler_t scheduler;
+    scheduler_entry_t typed[2], prefetch, visible;
+    uint64_t wait_ms;
+    scheduler_initialize(&scheduler, 4, 10, 2);
+    scheduler_add(&scheduler, &typed[0], SCHEDULER_PRIORITY_TYPED);
+    scheduler_add(&scheduler, &typed[1], SCHEDULER_PRIORITY_TYPED);
+    scheduler_add(&scheduler, &prefetch, SCHEDULER_PRIORITY_PREFETCH);
+
+    CU_ASSERT_PTR_EQUAL(scheduler_take(&scheduler, 0, &wait_ms), &typed[0]);
+    CU_ASSERT_PTR_EQUAL(scheduler_take(&scheduler, 0, &wait_ms), &typed[1]);
+    CU_ASSERT_PTR_NULL(scheduler_take(&scheduler, 0, &wait_ms));
+    CU_ASSERT_EQUAL(wait_ms, 101);
+
+    // The page that the user is waiting for is never held back, but uses a token
+    scheduler_add(&scheduler, &visible, SCHEDULER_PRIORITY_VISIBLE);
+    CU_ASSERT_PTR_EQUAL(scheduler_take(&scheduler, 0, &wait_ms), &visible);
+    CU_ASSERT_PTR_NULL(scheduler_take(&scheduler, 150, &wait_ms));
+    CU_ASSERT_EQUAL(wait_ms, 51);
+    CU_ASSERT_PTR_EQUAL(scheduler_take(&scheduler, 200, &wait_ms), &prefetch);
+}
+
+void test_scheduler_local() {
+    scheduler_t scheduler;
+    scheduler_entry_t typed[2], local[3];
+    uint64_t wait_ms;
+    scheduler_initialize(&scheduler, 4, 10, 1);
+    scheduler_add(&scheduler, &typed[0], SCHEDULER_PRIORITY_TYPED);
+    scheduler_add(&scheduler, &typed[1], SCHEDULER_PRIORITY_TYPED);
+
+    for (int i = 0; i < 3; i++) {
+        scheduler_add(&scheduler, &local[i], SCHEDULER_PRIORITY_LOCAL);
+    }
+
+    // Local work is not rate limited, but still leaves a slot for the page that is shown
+    CU_ASSERT_PTR_EQUAL(scheduler_take(&scheduler, 0, &wait_ms), &typed[0]);
+    CU_ASSERT_PTR_EQUAL(scheduler_take(&scheduler, 0, &wait_ms), &local[0]);
+    CU_ASSERT_PTR_EQUAL(scheduler_take(&scheduler, 0, &wait_ms), &local[1]);
+    CU_ASSERT_PTR_NULL(scheduler_take(&scheduler, 0, &wait_ms));
+
+    scheduler_finish(&scheduler, &local[0]);
+    CU_ASSERT_PTR_EQUAL(scheduler_take(&scheduler, 0, &wait_ms), &local[2]);
+    scheduler_finish(&scheduler, &local[1]);
+    scheduler_finish(&scheduler, &local[2]);
+    CU_ASSERT_PTR_NULL(scheduler_take(&scheduler, 0, &wait_ms));
+
+    // An entry that did not make a request after all gives its token back
+    scheduler_finish(&scheduler, &typed[0]);
+    scheduler_refund(&scheduler, &typed[0]);
+    CU_ASSERT_PTR_EQUAL(scheduler_take(&scheduler, 0, &wait_ms), &typed[1]);
+}
+
+void assert_style_colors(page_token_attr_t fg, page_token_attr_t bg, short expected_fg, short expected_bg) {
+    page_token_style_t style = {.fg = fg, .bg = bg, .extra = PAGE_TOKEN_ATTR_NONE};
+    short pair = PAIR_NUMBER(colors_get_color_pair_from_style(style));
+    short pair_fg, pair_bg;
+
+    CU_ASSERT_TRUE(pair >= COLORSCHEME_TABLE_FIRST && pair < COLORS_PAIR_COUNT);
+    CU_ASSERT_EQUAL_FATAL(pair_content(pair, &pair_fg, &pair_bg), OK);
+    CU_ASSERT_EQUAL(pair_fg, expected_fg);
+    CU_ASSERT_EQUAL(pair_bg, expected_bg);
+}
+
+void test_colors_table() {
+    CU_ASSERT_TRUE_FATAL(start_test_terminal("xterm-256color"));
+    colors_initialize(true, false);
+
+    // Every combination has its own pair, also the ones that used to get the default
+    assert_style_colors(PAGE_TOKEN_ATTR_RED, PAGE_TOKEN_ATTR_BG_BLACK, COLOR_RED, COLOR_BLACK);
+    assert_style_colors(PAGE_TOKEN_ATTR_GREEN, PAGE_TOKEN_ATTR_BG_BLACK, COLOR_GREEN, COLOR_BLACK);
+    assert_style_colors(PAGE_TOKEN_ATTR_WHITE, PAGE_TOKEN_ATTR_BG_YELLOW, COLOR_WHITE, COLOR_YELLOW);
+    assert_style_colors(PAGE_TOKEN_ATTR_CYAN, PAGE_TOKEN_ATTR_BG_BLACK, COLOR_CYAN, COLOR_BLACK);
+
+    // Text with the color of the background gets a color that can be read
+    assert_style_colors(PAGE_TOKEN_ATTR_YELLOW, PAGE_TOKEN_ATTR_BG_YELLOW, COLOR_BLUE, COLOR_YELLOW);
+    assert_style_colors(PAGE_TOKEN_ATTR_BLUE, PAGE_TOKEN_ATTR_BG_BLUE, COLOR_YELLOW, COLOR_BLUE);
+    assert_style_colors(PAGE_TOKEN_ATTR_RED, PAGE_TOKEN_ATTR_BG_RED, COLOR_WHITE, COLOR_RED);
+    assert_style_colors(PAGE_TOKEN_ATTR_GREEN, PAGE_TOKEN_ATTR_BG_GREEN, COLOR_BLACK, COLOR_GREEN);
+
+    // Without its own colors, the text on colored backgrounds is black
+    colors_initialize(false, true);
+    assert_style_colors(PAGE_TOKEN_ATTR_WHITE, PAGE_TOKEN_ATTR_BG_BLUE, COLOR_BLACK, COLOR_BLUE);
+    assert_style_colors(PAGE_TOKEN_ATTR_RED, PAGE_TOKEN_ATTR_BG_BLACK, COLOR_RED, -1);
+    stop_test_terminal();
+}
+
+#define ANSI_TEST_BUF_SIZE 4096
+#define ANSI_PAIR       1   // white on black
+#define ANSI_PAIR_BLUE  2   // yellow on blue
+#define ANSI_PAIR_PLAIN 3   // white on the default background
+#define ANSI_PAIR_WHITE 4   // white on blue
+
+/// @brief Starts a terminal of the type with known color pairs for the minimal ANSI output
+bool start_ansi_terminal(const char *type) {
+    if (!start_test_terminal(type)) {
+        return false;
+    }
+
+    start_color();
+    use_default_colors();
+    init_pair(ANSI_PAIR, COLOR_WHITE, COLOR_BLACK);
+    init_pair(ANSI_PAIR_BLUE, COLOR_YELLOW, COLOR_BLUE);
+    init_pair(ANSI_PAIR_PLAIN, COLOR_WHITE, -1);
+    init_pair(ANSI_PAIR_WHITE, COLOR_WHITE, COLOR_BLUE);
+    ansi_initialize(false, true);
+    return true;
+}
+
+/// @brief Presents the frame and reads back what was written to stdout
+/// @return the number of bytes that 'ansi_present()' reported
+size_t present_captured(frame_t *shown, frame_t *next, int origin_col, char *buf) {
+    FILE *capture = tmpfile();
+    int stdout_fd = dup(STDOUT_FILENO);
+    fflush(stdout);
+    dup2(fileno(capture), STDOUT_FILENO);
+    size_t size = ansi_present(shown, next, 0, origin_col, false);
+    dup2(stdout_fd, STDOUT_FILENO);
+    close(stdout_fd);
+
+    rewind(capture);
+    size_t read = fread(buf, 1, ANSI_TEST_BUF_SIZE - 1, capture);
+    buf[read] = '\0';
+    fclose(capture);
+    CU_ASSERT_EQUAL(read, size);
+    return size;
+}
+
+void assert_presented(frame_t *shown, frame_t *next, int origin_col, const char *expected) {
+    char buf[ANSI_TEST_BUF_SIZE];
+    CU_ASSERT_EQUAL(present_captured(shown, next, origin_col, buf), strlen(expected));
+    CU_ASSERT_STRING_EQUAL(buf, expected);
+
+    // The shown frame is updated, so presenting it again writes nothing
+    CU_ASSERT_EQUAL(memcmp(shown, next, sizeof(frame_t)), 0);
+    CU_ASSERT_EQUAL(present_captured(shown, next, origin_col, buf), 0);
+}
+
+/// @brief Clears both frames and fills a line of the shown frame, so that it is the only one that changes
+void set_up_frames(frame_t *shown, frame_t *next, int line, char glyph) {
+    frame_clear(shown, COLOR_PAIR(ANSI_PAIR));
+
+    for (int col = 0; col < PAGE_COLS; col++) {
+        shown->cells[line][col] = glyph | COLOR_PAIR(ANSI_PAIR);
+    }
+
+    memcpy(next, shown, sizeof(frame_t));
+}
+
+void test_ansi_skip() {
+    static frame_t shown, next;
+    CU_ASSERT_TRUE_FATAL(start_ansi_terminal("xterm-256color"));
+
+    // Five unchanged cells are skipped by moving the cursor
+    set_up_frames(&shown, &next, 0, ' ');
+    next.cells[0][0] = 'A' | COLOR_PAIR(ANSI_PAIR);
+    next.cells[0][6] = 'B' | COLOR_PAIR(ANSI_PAIR);
+    assert_presented(&shown, &next, 0, "\0337\033[1;1H\033[0;37;40mA\033[5CB\0338");
+
+    // Four are cheaper to write again
+    set_up_frames(&shown, &next, 0, ' ');
+    next.cells[0][0] = 'A' | COLOR_PAIR(ANSI_PAIR);
+    next.cells[0][5] = 'B' | COLOR_PAIR(ANSI_PAIR);
+    assert_presented(&shown, &next, 0, "\0337\033[1;1H\033[0;37;40mA    B\0338");
+
+    // Only the changed lines are written
+    set_up_frames(&shown, &next, 0, ' ');
+    next.cells[2][3] = 'C' | COLOR_PAIR(ANSI_PAIR);
+    next.cells[5][0] = 'D' | COLOR_PAIR(ANSI_PAIR);
+    assert_presented(&shown, &next, 0, "\0337\033[3;4H\033[0;37;40mC\033[6;1HD\0338");
+    stop_test_terminal();
+}
+
+void test_ansi_sgr_changes() {
+    static frame_t shown, next;
+    CU_ASSERT_TRUE_FATAL(start_ansi_terminal("xterm-256color"));
+
+    // Only the attributes and colors that change are written after the first cell
+    set_up_frames(&shown, &next, 2, ' ');
+    next.cells[2][0] = 'a' | COLOR_PAIR(ANSI_PAIR);
+    next.cells[2][1] = 'b' | COLOR_PAIR(ANSI_PAIR) | A_BOLD;
+    next.cells[2][2] = 'c' | COLOR_PAIR(ANSI_PAIR_WHITE);
+    next.cells[2][3] = 'd' | COLOR_PAIR(ANSI_PAIR_BLUE);
+    next.cells[2][4] = 'e' | COLOR_PAIR(ANSI_PAIR_BLUE) | A_UNDERLINE;
+    next.cells[2][5] = 'f' | COLOR_PAIR(ANSI_PAIR);
+    assert_presented(
+        &shown,
+        &next,
+        0,
+        "\0337\033[3;1H\033[0;37;40ma\033[1mb\033[22;44mc\033[33md\033[4me\033[24;37;40mf\0338"
+    );
+    stop_test_terminal();
+}
+
+void test_ansi_erase() {
+    static frame_t shown, next;
+    char expected[ANSI_TEST_BUF_SIZE];
+    CU_ASSERT_TRUE_FATAL(start_ansi_terminal("xterm-256color"));
+
+    // The rest of the line is erased, which fills it with the background color with bce
+    set_up_frames(&shown, &next, 1, 'X');
+    frame_print(&next, 1, 0, "Y                                       ", COLOR_PAIR(ANSI_PAIR));
+    assert_presented(&shown, &next, 0, "\0337\033[2;1H\033[0;37;40mY\033[39X\0338");
+
+    // Erasing to the end of the terminal line is only possible at the right edge of the terminal
+    set_up_frames(&shown, &next, 1, 'X');
+    frame_print(&next, 1, 0, "Y                                       ", COLOR_PAIR(ANSI_PAIR));
+    snprintf(expected, sizeof(expected), "\0337\033[2;%dH\033[0;37;40mY\033[K\0338", COLS - PAGE_COLS + 1);
+    assert_presented(&shown, &next, COLS - PAGE_COLS, expected);
+
+    // In the middle of the line, the cursor must also be moved past the erased cells
+    set_up_frames(&shown, &next, 3, 'X');
+    frame_print(&next, 3, 0, "Z          W", COLOR_PAIR(ANSI_PAIR));
+    assert_presented(&shown, &next, 0, "\0337\033[4;1H\033[0;37;40mZ\033[10X\033[10CW\0338");
+
+    // Which is not worth it for shorter runs
+    set_up_frames(&shown, &next, 3, 'X');
+    frame_print(&next, 3, 0, "Z         W", COLOR_PAIR(ANSI_PAIR));
+    assert_presented(&shown, &next, 0, "\0337\033[4;1H\033[0;37;40mZ         W\0338");
+    stop_test_terminal();
+}
+
+void test_ansi_erase_without_bce() {
+    static frame_t shown, next;
+    char expected[ANSI_TEST_BUF_SIZE];
+    CU_ASSERT_TRUE_FATAL(start_ansi_terminal("screen"));
+
+    // Erased cells would get the default background, so colored blanks are written out
+    set_up_frames(&shown, &next, 1, 'X');
+    frame_print(&next, 1, 0, "Y                                       ", COLOR_PAIR(ANSI_PAIR));
+    snprintf(expected, sizeof(expected), "\0337\033[2;1H\033[0;37;40mY%39s\0338", "");
+    assert_presented(&shown, &next, 0, expected);
+
+    // Blanks on the default background can still be erased
+    set_up_frames(&shown, &next, 1, 'X');
+    frame_print(&next, 1, 0, "Y                                       ", COLOR_PAIR(ANSI_PAIR_PLAIN));
+    assert_presented(&shown, &next, 0, "\0337\033[2;1H\033[0;37;49mY\033[K\0338");
+    stop_test_terminal();
+}
+
+void test_frame_present() {
+    static frame_t shown, next, window;
+    CU_ASSERT_TRUE_FATAL(start_test_terminal("xterm-256color"));
+    WINDOW *win = newwin(PAGE_LINES, PAGE_COLS, 0, 0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(win);
+
+    frame_clear(&shown, A_NORMAL);
+    CU_ASSERT_EQUAL(frame_present(win, &shown, &shown, true), PAGE_LINES * PAGE_COLS);
+    memcpy(&next, &shown, sizeof(frame_t));
+
+    // Only the cells from the first to the last change of each line are written
+    frame_print(&next, 4, 3, "a", A_NORMAL);
+    frame_print(&next, 4, 7, "b", A_BOLD);
+    frame_print(&next, 9, 0, "c", A_NORMAL);
+    CU_ASSERT_EQUAL(frame_present(win, &shown, &next, false), 6);
+    CU_ASSERT_EQUAL(memcmp(&shown, &next, sizeof(frame_t)), 0);
+    CU_ASSERT_EQUAL(frame_present(win, &shown, &next, false), 0);
+
+    frame_from_window(&window, win);
+    CU_ASSERT_EQUAL(memcmp(&window, &next, sizeof(frame_t)), 0);
+
+    delwin(win);
+    stop_test_terminal();
+}
+
+void test_frame_cache() {
+    page_t *pages[FRAME_CACHE_SIZE + 1];
+    page_t *empty = page_create_empty();
+    empty->serial = 0;
+
+    for (int i = 0; i <= FRAME_CACHE_SIZE; i++) {
+        pages[i] = page_create_empty();
+    }
+
+    // Pages without a serial can not be told apart and are never cached
+    CU_ASSERT_PTR_NULL(frame_cache_put(empty));
+    CU_ASSERT_PTR_NULL(frame_cache_get(empty));
+    CU_ASSERT_PTR_NULL(frame_cache_get(pages[0]));
+
+    frame_t *frame = frame_cache_put(pages[0]);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(frame);
+    CU_ASSERT_PTR_EQUAL(frame_cache_get(pages[0]), frame);
+    CU_ASSERT_PTR_EQUAL(frame_cache_put(pages[0]), frame);
+
+    for (int i = 1; i < FRAME_CACHE_SIZE; i++) {
+        CU_ASSERT_PTR_NOT_NULL(frame_cache_put(pages[i]));
+    }
+
+    // The least recently used frame is replaced, which is no longer the first one
+    CU_ASSERT_PTR_EQUAL(frame_cache_get(pages[0]), frame);
+    CU_ASSERT_PTR_NOT_NULL(frame_cache_put(pages[FRAME_CACHE_SIZE]));
+    CU_ASSERT_PTR_EQUAL(frame_cache_get(pages[0]), frame);
+    CU_ASSERT_PTR_NULL(frame_cache_get(pages[1]));
+
+    for (int i = 2; i <= FRAME_CACHE_SIZE; i++) {
+        CU_ASSERT_PTR_NOT_NULL(frame_cache_get(pages[i]));
+    }
+
+    for (int i = 0; i <= FRAME_CACHE_SIZE; i++) {
+        page_destroy(pages[i]);
+    }
+
+    page_destroy(empty);
+}
+
+static void *set_thread_error(void *data) {
+    error_set_with_format(TTT_ERROR_REQUEST_FAILED, "ERROR: Request %d failed", 2);
+    error_save(data);
+    return NULL;
+}
+
+void test_error_thread_local() {
+    pthread_t thread;
+    error_context_t context;
+    error_set(TTT_ERROR_HTML_PARSER_FAILED);
+    CU_ASSERT_EQUAL_FATAL(pthread_create(&thread, NULL, set_thread_error, &context), 0);
+    pthread_join(thread, NULL);
+
+    // The error of the other thread is returned in its context, without changing this one
+    CU_ASSERT_EQUAL(error_get(), TTT_ERROR_HTML_PARSER_FAILED);
+    CU_ASSERT_STRING_EQUAL(error_get_string(), "ERROR: Could not parse HTML page content");
+    CU_ASSERT_EQUAL(context.code, TTT_ERROR_REQUEST_FAILED);
+    CU_ASSERT_STRING_EQUAL(error_get_context_string(&context), "ERROR: Request 2 failed");
+    error_reset();
+    CU_ASSERT_PTR_NULL(error_get_string());
+}
+
+void test_error_long_string() {
+    char str[ERROR_STRING_SIZE * 2];
+    memset(str, 'e', sizeof(str) - 1);
+    str[sizeof(str) - 1] = '\0';
+    error_set_with_string(TTT_ERROR_PAGE_PARSER_FAILED, str);
+    CU_ASSERT_EQUAL(strlen(error_get_string()), ERROR_STRING_SIZE - 1);
+
+    // A new error does not keep the message of the previous one
+    error_set(TTT_ERROR_OUT_OF_MEMORY);
+    CU_ASSERT_STRING_EQUAL(error_get_string(), "ERROR: Out of memory");
+    error_reset();
+}
+
 int main() {
     if (
         !load_test_data(&JSON_DATA_PAGE, JSON_DATA_PAGE_PATH) ||
@@ -999,6 +2136,18 @@ int main() {
     CU_initialize_registry();
     CU_pSuite page_parser_suite = CU_add_suite("Page parser tests", 0, 0);
     CU_pSuite html_parser_suite = CU_add_suite("HTML parser tests", 0, 0);
+    CU_pSuite grid_suite = CU_add_suite("Page grid tests", 0, 0);
+    CU_pSuite events_suite = CU_add_suite("Event loop tests", 0, 0);
+    CU_pSuite cache_suite = CU_add_suite("Page cache tests", 0, 0);
+    CU_pSuite history_suite = CU_add_suite("History tests", 0, 0);
+    CU_pSuite search_suite = CU_add_suite("Search index tests", 0, 0);
+    CU_pSuite store_suite = CU_add_suite("Page store tests", 0, 0);
+    CU_pSuite queue_suite = CU_add_suite("Queue tests", 0, 0);
+    CU_pSuite error_suite = CU_add_suite("Error tests", 0, 0);
+    CU_pSuite scheduler_suite = CU_add_suite("Scheduler tests", 0, 0);
+    CU_pSuite transitions_suite = CU_add_suite("Transition model tests", 0, 0);
+    CU_pSuite colors_suite = CU_add_suite("Color tests", 0, 0);
+    CU_pSuite render_suite = CU_add_suite("Render tests", 0, 0);
 
     CU_add_test(page_parser_suite, "test_page_null_string", test_page_null_string);
     CU_add_test(page_parser_suite, "test_page_empty_string", test_page_empty_string);
@@ -1011,6 +2160,9 @@ int main() {
     CU_add_test(page_parser_suite, "test_page_collection_empty_objects", test_page_collection_empty_objects);
     CU_add_test(page_parser_suite, "test_page_large_content_array", test_page_large_content_array);
     CU_add_test(page_parser_suite, "test_page_single", test_page_single);
+    CU_add_test(page_parser_suite, "test_page_collection_range", test_page_collection_range);
+    CU_add_test(page_parser_suite, "test_page_collection_invalid", test_page_collection_invalid);
+    CU_add_test(page_parser_suite, "test_page_sources", test_page_sources);
 
     CU_add_test(html_parser_suite, "test_page_html_null", test_page_html_null);
     CU_add_test(html_parser_suite, "test_page_html_invalid_start_tag", test_page_html_invalid_start_tag);
@@ -1031,6 +2183,49 @@ int main() {
     CU_add_test(html_parser_suite, "test_page_html_1", test_page_html_1);
     CU_add_test(html_parser_suite, "test_page_html_3", test_page_html_3);
 
+    CU_add_test(grid_suite, "test_grid_empty_page", test_grid_empty_page);
+    CU_add_test(grid_suite, "test_grid_line_wrap", test_grid_line_wrap);
+    CU_add_test(grid_suite, "test_grid_rows_equal_style", test_grid_rows_equal_style);
+    CU_add_test(grid_suite, "test_grid_html_1", test_grid_html_1);
+    CU_add_test(grid_suite, "test_grid_links", test_grid_links);
+    CU_add_test(grid_suite, "test_grid_many_links", test_grid_many_links);
+
+    CU_add_test(events_suite, "test_events_timer", test_events_timer);
+    CU_add_test(events_suite, "test_events_fd", test_events_fd);
+
+    CU_add_test(cache_suite, "test_cache_get", test_cache_get);
+    CU_add_test(cache_suite, "test_cache_replace", test_cache_replace);
+    CU_add_test(cache_suite, "test_cache_eviction", test_cache_eviction);
+    CU_add_test(history_suite, "test_history_back_forward", test_history_back_forward);
+    CU_add_test(history_suite, "test_history_pins_pages", test_history_pins_pages);
+    CU_add_test(history_suite, "test_history_replace_current", test_history_replace_current);
+    CU_add_test(search_suite, "test_search_query", test_search_query);
+    CU_add_test(search_suite, "test_search_reindex", test_search_reindex);
+    CU_add_test(store_suite, "test_store_pages", test_store_pages);
+    CU_add_test(store_suite, "test_store_range", test_store_range);
+    CU_add_test(store_suite, "test_store_last_page", test_store_last_page);
+    CU_add_test(queue_suite, "test_queue_order", test_queue_order);
+    CU_add_test(queue_suite, "test_queue_threads", test_queue_threads);
+    CU_add_test(error_suite, "test_error_thread_local", test_error_thread_local);
+    CU_add_test(error_suite, "test_error_long_string", test_error_long_string);
+
+    CU_add_test(scheduler_suite, "test_scheduler_priority", test_scheduler_priority);
+    CU_add_test(scheduler_suite, "test_scheduler_limits", test_scheduler_limits);
+    CU_add_test(scheduler_suite, "test_scheduler_rate_limit", test_scheduler_rate_limit);
+    CU_add_test(scheduler_suite, "test_scheduler_local", test_scheduler_local);
+
+    CU_add_test(transitions_suite, "test_transitions_predict", test_transitions_predict);
+    CU_add_test(transitions_suite, "test_transitions_persist", test_transitions_persist);
+
+    CU_add_test(colors_suite, "test_colors_table", test_colors_table);
+
+    CU_add_test(render_suite, "test_ansi_skip", test_ansi_skip);
+    CU_add_test(render_suite, "test_ansi_sgr_changes", test_ansi_sgr_changes);
+    CU_add_test(render_suite, "test_ansi_erase", test_ansi_erase);
+    CU_add_test(render_suite, "test_ansi_erase_without_bce", test_ansi_erase_without_bce);
+    CU_add_test(render_suite, "test_frame_present", test_frame_present);
+    CU_add_test(render_suite, "test_frame_cache", test_frame_cache);
+
     CU_basic_set_mode(CU_BRM_VERBOSE);
     CU_basic_run_tests();
     CU_cleanup_registry();